@@ -1,73 +1,891 @@
+#define _GNU_SOURCE                         // O_DIRECT, qsort_r and syscall
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
-#include <windows.h>
 #include <time.h>
 #include <unistd.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define FRAME_TABLE_SIMD                   // SSE4.1/AVX2 frame table kernels, chosen at run time
+#endif
 
-#define MAX_PAGES 100
-#define MAX_PROCESSES 100
-#define MAX_FRAMES 100
-#define MAX_DISK_PAGES 200
-double system_frame_size ;
-long long process_used_memory;
+#define DEFAULT_REPLAY_FRAMES 100           // Frames used by trace replay when --frames is not given
+#define TRACE_PAGE_KB 4                    // Page size of trace records; sweeps group them into larger pages
+#define WORKLOAD_PHASES 8                   // Working-set phases of the phase-shifting workload
+#define MAX_SWEEP_VALUES 64                // Values accepted per sweep axis
+#define SWAP_STRIPES 16                    // Lock stripes over swap slots in the concurrent simulation
+#define CONCURRENT_QUANTUM 64              // References a process runs before the next on its thread
+#define CONCURRENT_FAULT_TOLERANCE 0.01    // Fault-count difference beyond which runs get no speedup
+#define SWAP_CLUSTER_PAGES 64              // Victim pages gathered before the swap file is written
+#define READAHEAD_MIN_PAGES 2              // Smallest swap-in readahead window
+#define READAHEAD_MAX_PAGES 32             // Largest swap-in readahead window
+#define LZ_MIN_MATCH 4                     // Shortest match the LZ codec encodes
+#define LZ_HASH_BITS 12                    // log2 of the LZ match finder's hash table size
+#define SLAB_MAX_CLASSES 64                 // Slab size classes, from 8 bytes up to half a page
+#define SLAB_EMPTY_KEEP 1                   // Empty slabs a cache keeps before returning frames
+#define SLAB_OWNER 0                        // Frame table process ID of frames holding slabs
+#define SHARED_OWNER -2                     // Frame table process ID of frames shared copy-on-write
+#define CONTIGUOUS_CLASSES 31               // Size classes of the segregated-fit allocator (powers of two)
+#define BUDDY_MAX_ORDER 31                  // Buddy blocks range from 1 to 2^30 units
+#define CHURN_SAMPLE_INTERVAL 1024          // Operations between fragmentation samples in the churn benchmark
+#define TLB_ENTRIES 64                      // Default base-page TLB entries
+#define TLB_WAYS 4                          // Default TLB associativity, shared by both arrays
+#define HUGE_TLB_ENTRIES 32                 // Default huge-page TLB entries
+#define WALK_CACHE_ENTRIES 16               // Page-walk cache entries per upper page-table level
+#define WORKING_SET_WINDOW 1000             // Default working-set window, in references of the process
+#define LOAD_CONTROL_INTERVAL 256           // References between thrashing checks in a process run
+#define THRASH_FAULT_RATE 0.1               // Window fault rate that, with demand above memory, is thrashing
+#define RUN_WRITE_PERCENT 30                // Share of a process run's references that write their page
+#define TELEMETRY_INTERVAL 1000             // Default references between telemetry samples
+#define MEMORY_MAP_MAX_RUNS 64              // Runs of frames the memory map shows before it stops
+#define LOAD_CONTROL_ROTATION 64            // Checks a process runs before it may be swapped out for one that waits
+#define PAGE_TABLE_LEVELS 4                 // Radix page-table levels, root first
+#define PAGE_TABLE_BITS 9                   // Index bits per level: 512 eight-byte entries per table page
+#define HUGE_PAGE_PAGES (1 << PAGE_TABLE_BITS) // Base pages in a huge page, a page-directory leaf (2 MB of 4 KB pages)
+#define DISK_CHUNK_PAGES 4096              // Swap slots added to the disk pool at a time
+#define ARENA_ALIGNMENT 16                 // Alignment of every arena allocation
+#define TRACE_CHUNK_SIZE (4 * 1024 * 1024) // Bytes read from a trace file per fread
+#define PAGE_KEY_NONE UINT64_MAX           // Marks an empty frame in the replacement loop
+#define SCAN_LOOKUP_MAX_FRAMES 16          // Up to this many frames, a vector scan beats the page index
+#define FRAME_DIRTY 0x01                   // Frame table flag: page written since it was loaded
+#define FRAME_REFERENCED 0x02              // Frame table flag: reference bit used by CLOCK
+#define LATENCY_BUCKETS 1024              // Log-linear latency histogram buckets (16 per power of two)
+#define PAGE_UNMAPPED -1                   // Page table entry of a page with no frame or swap slot
+#define PAGE_ON_DISK(entry) ((entry) <= -2)         // Page table entry refers to a swap slot
+#define SWAP_SLOT_ENTRY(slot) (-(slot) - 2)         // Encodes a swap slot as a page table entry
+#define ENTRY_SWAP_SLOT(entry) (-(entry) - 2)       // Decodes the swap slot of a page table entry
+
+typedef uint64_t page_key;   // (process_id << 32) | page_number, identifies one virtual page
 
 typedef enum {
     WAITING,
     RUNNING,
-    COMPLETED
+    COMPLETED,
+    SUSPENDED               // Swapped out whole by load control until its working set fits again
 } ProcessState;
 
+typedef struct {
+    int slab;               // Slab holding the object
+    int slot;               // Object position within the slab
+    int size;               // Bytes requested; the slab's size class may be larger
+} SlabObject;
+
 typedef struct {
     int process_id;
     int memory_requirement; // in KB
     int allocated;          // Flag for memory allocation status
     ProcessState state;     // Current state of the process
+    int* page_table;        // Per page: frame index, SWAP_SLOT_ENTRY(slot) or PAGE_UNMAPPED
+    int page_table_size;    // Number of page table entries
+    int resident_pages;     // Pages currently held in frames
+    int mapped_pages;       // Pages with a frame or a swap slot
+    int huge_regions;       // Page-table regions currently mapped by a huge page
+    int last_fault_page;    // Page of the last swap-in fault or readahead hit, 0 if none yet
+    int fault_stride;       // Distance between the last two of them
+    int readahead_window;   // Pages read ahead once a stride repeats; adapts to hits and waste
+    long long* last_use;    // Per page: the process's virtual time at its last reference, 0 if never
+    long long virtual_time; // References the process has made
+    long long faults;       // Page faults the process has taken
+    int working_set;        // Working set when suspended, which must fit before it is resumed
+    int deferred;           // 1 while load control keeps the process waiting for frames
+    long long queued_at;    // Load control check at which it was deferred or suspended
+    long long admitted_at;  // Load control check at which it was admitted or resumed
+    SlabObject* objects;    // Small objects allocated from the slab caches
+    int object_count;
+    int object_capacity;
+    long long object_bytes_requested; // Bytes asked for by those objects
+    long long object_bytes_consumed;  // Bytes of the size classes that hold them
 } Process;
 
+// The frame table doubles as the reverse map: each frame records the (process, page) it holds.
+// Entries are packed into 8 bytes, so a 16M-frame table takes 128 MB.
 typedef struct {
-    int assigned;      // 1 if frame is assigned, 0 otherwise
-    int process_id;    // Process ID assigned to this frame
-    int page_number;   // Page number within the process
+    unsigned int assigned : 1;     // 1 if frame is assigned, 0 otherwise
+    unsigned int prefetched : 1;   // Brought in by readahead and not referenced since
+    unsigned int huge : 1;         // Part of a huge page: an aligned run of HUGE_PAGE_PAGES frames
+    signed int process_id : 29;    // Process ID assigned to this frame, or SLAB_OWNER or SHARED_OWNER
+    int page_number;               // Page number within the process (1-based); mappings of a shared frame
 } Frame;
 
 typedef struct {
     int process_id;    // Process ID assigned to this page
     int page_number;   // Page number of the process
     int in_memory;     // 1 if the page is in memory, 0 if it's on disk
+    page_key content;  // Key stamped on the page image, which swap-in checks it against
 } DiskPage;
 
+enum { PROBE_OTHER, PROBE_TRACE_LOAD, PROBE_ALLOCATION, PROBE_REPLACEMENT, PROBE_SWAP, PROBE_DEDUP, PROBE_PHASES };
+enum { PROBE_CYCLES, PROBE_CACHE_MISSES, PROBE_DTLB_MISSES, PROBE_COUNTERS };
+
+typedef struct {
+    double wall_ns;
+    double user_us;          // CPU time from getrusage
+    double system_us;
+    long long minor_faults;  // Pages the simulator touched for the first time
+    long long major_faults;
+    long long counters[PROBE_COUNTERS]; // Cycles, cache misses and dTLB read misses
+} ProbeSample;
+
+typedef struct {
+    int enabled;
+    int fds[PROBE_COUNTERS]; // perf_event file descriptors, -1 where a counter is unavailable
+    int current;             // Phase being charged
+    ProbeSample last;        // Reading taken at the last phase change
+    ProbeSample totals[PROBE_PHASES];
+    long long entries[PROBE_PHASES];
+} Probe;
+
+typedef struct ArenaBlock {
+    struct ArenaBlock* next; // Previously filled block
+    size_t size;             // Usable bytes in this block
+    size_t used;             // Bytes handed out from this block
+    unsigned char* data;     // Start of the usable bytes
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock* head;        // Block currently being filled
+    size_t block_size;       // Default size of a new block
+} Arena;
+
+typedef struct {
+    DiskPage** chunks;       // Chunks of DISK_CHUNK_PAGES swap slots, carved from an arena
+    int chunk_count;         // Chunks allocated
+    int chunk_capacity;      // Entries in the chunks array
+    int next_unused;         // Slots handed out at least once
+    int free_head;           // First released slot, chained through page_number; -1 if none
+    Arena* arena;            // Arena the chunks come from
+} DiskPool;
+
 typedef struct {
     int page_faults;
-    int swap_time;     // In milliseconds
+    double swap_time;  // In microseconds of simulated device time
+    int prefetched_pages; // Pages brought in by swap-in readahead
+    int prefetch_hits;    // Prefetched pages referenced before being evicted, each a fault avoided
+    int prefetch_wasted;  // Prefetched pages swapped out or freed without being referenced
+    long long tlb_lookups;   // Page accesses translated
+    long long tlb_hits;      // Translations found in either TLB array
+    long long huge_tlb_hits; // Of those, hits in the huge-page array
+    long long page_walks;    // TLB misses that walked the page table
+    long long walk_levels;   // Page-table levels read by those walks
+    long long walk_cache_hits; // Walks that started below the root thanks to the page-walk caches
+    double translation_ns;   // Walk time: each level read costs a DRAM access
+    int huge_pages;          // Huge pages currently mapped
+    int huge_splits;         // Huge pages split because one of their pages was swapped out
+    int shared_frames;       // Frames currently shared copy-on-write
+    int shared_mappings;     // Page table entries pointing at them; each beyond the first saves a frame
+    int cow_faults;          // Writes to a shared frame
+    int cow_copies;          // Of those, writes that copied the page to a frame of the writer's own
+    int cow_reuses;          // Writes by the last mapping, which took the frame over without a copy
+    long long references;    // Page references made, the virtual time telemetry is sampled on
+    long long reference_faults; // Of those, references that found their page on disk
+    long long swap_outs;     // Pages written to swap slots
+    long long swap_ins;      // Pages read back from them, readahead included
 } MemoryStats;
 
-Frame RAM[MAX_FRAMES];       // RAM with a limited number of frames
-DiskPage disk[MAX_DISK_PAGES]; // Disk storage
+// One telemetry sample, as written to a binary log after the "MSTL" magic and the record size
+typedef struct {
+    int64_t references;      // Virtual time of the sample
+    int64_t used_frames;
+    int64_t shared_frames;
+    int64_t disk_pages;      // Pages held in swap slots
+    int64_t swap_outs;       // Pages swapped out since the last sample
+    int64_t swap_ins;        // Pages swapped in since the last sample
+    double utilization;      // Share of frames in use, 0 to 1
+    double fault_rate;       // Faults per reference since the last sample
+    double swap_time_us;     // Simulated swap device time so far
+} TelemetryRecord;
+
+typedef struct {
+    FILE* file;              // Log the samples go to, NULL while telemetry is off
+    int binary;              // 1 for TelemetryRecords, 0 for CSV rows
+    long long interval;      // References between samples
+    long long next_sample;   // Reference count at which the next sample is due
+    long long samples;       // Samples written
+    TelemetryRecord last;    // Previous sample, whose counters the next one is the difference from
+    long long last_faults;
+    long long last_swap_outs;
+    long long last_swap_ins;
+} Telemetry;
+
+typedef struct {
+    int enabled;             // 0 runs every process and replaces pages globally, whatever the load
+    int window;              // Working-set window: pages referenced in the last window references
+    int hand;                // WSClock hand over the frame table
+    long long window_references; // References and faults since the last thrashing check
+    long long window_faults;
+    long long checks;        // Thrashing checks made
+    long long thrashing_windows; // Checks that found demand above memory and a high fault rate
+    long long suspensions;
+    long long rotations;     // Suspensions that let a waiting process have its turn
+    long long resumptions;
+    long long admissions;    // Deferred processes admitted once their pages fit
+    long long deferrals;
+} LoadControl;
+
+typedef struct {
+    int prefix;              // Free frames at the start of a span of the bitmap
+    int suffix;              // Free frames at its end
+    int best;                // Longest run of free frames within it
+} FreeRun;
+
+typedef struct {
+    uint64_t* words;         // Bit i is set while frame i is free
+    int word_count;          // Number of 64-bit words in the bitmap
+    int total_frames;        // Number of frames tracked
+    int free_frames;         // Free frames, kept up to date on every allocate and free
+    int search_hint;         // First word that may still hold a free frame
+    FreeRun* runs;           // Segment tree over the words, node 1 the root, leaves from run_leaves on
+    int run_leaves;          // Leaves of the tree, the word count rounded up to a power of two
+} FrameAllocator;
+
+enum { SLAB_PARTIAL, SLAB_FULL, SLAB_EMPTY, SLAB_LISTS };
+
+typedef struct {
+    int frame;               // Frame holding the slab's objects, -1 while the entry is unused
+    int cache;               // Size class the slab serves
+    int in_use;              // Objects handed out
+    int list;                // SLAB_PARTIAL, SLAB_FULL or SLAB_EMPTY; -1 while on no list
+    int prev;                // Links within that list; next also chains unused entries
+    int next;
+    uint64_t* free_map;      // Bit i is set while object i is free
+} Slab;
+
+typedef struct {
+    int object_size;         // Bytes per object
+    int objects_per_slab;    // Objects that fit in one page
+    int lists[SLAB_LISTS];   // First slab on the partial, full and empty lists
+    int slab_count[SLAB_LISTS];
+    long long objects_in_use;
+    long long bytes_requested; // Bytes asked for by the objects in use
+} SlabCache;
+
+typedef struct {
+    SlabCache caches[SLAB_MAX_CLASSES];
+    int cache_count;
+    Slab* slabs;             // Slab entries, indexed by the slab numbers in SlabObject
+    int slab_count;
+    int slab_capacity;
+    int free_slab;           // First unused slab entry, -1 if none
+    size_t page_bytes;       // Bytes per slab (one frame)
+    long long allocations;
+    long long frees;
+    long long slabs_created;
+    long long slabs_released;
+} SlabAllocator;
+
+typedef struct {
+    int total_units;         // Units managed by a contiguous allocator
+    int free_units;          // Units not handed out, kept up to date on every allocate and free
+    void* data;              // Allocator-specific free-block bookkeeping
+} ContiguousState;
+
+typedef struct {
+    const char* name;
+    int (*init)(ContiguousState* state, int total_units);
+    int (*alloc)(ContiguousState* state, int units);                    // Returns the first unit, or -1
+    void (*release)(ContiguousState* state, int start, int units);
+    int (*largest_free)(const ContiguousState* state);                  // Largest block a request could get
+    void (*destroy)(ContiguousState* state);
+} ContiguousAllocator;
+
+typedef struct {
+    int* block_size;         // Size of the free block starting at each unit, 0 where none starts
+    int* block_head;         // First unit of the free block ending at each unit (boundary tag)
+    int* prev;               // Free-list links, indexed by a free block's first unit
+    int* next;
+    int heads[CONTIGUOUS_CLASSES]; // One address-ordered list, or one per size class when segregated
+    int segregated;          // Lists are split by size class
+    int best_fit;            // Search the whole list for the tightest block instead of the first
+} FreeBlockSet;
+
+typedef struct {
+    int8_t* order;           // Order of the free block starting at each unit, -1 where none starts
+    int* prev;               // Free-list links, indexed by a free block's first unit
+    int* next;
+    int heads[BUDDY_MAX_ORDER]; // Free blocks of each order
+} BuddyAllocator;
+
+typedef struct {
+    long long allocations;   // Allocation requests made
+    long long failures;      // Requests that found no block
+    long long failures_with_space; // Failed although the free units added up to the request
+    double external_fragmentation; // Mean of 1 - largest free block / free units
+    double internal_waste;   // Mean share of consumed units beyond what was requested
+    int final_largest_free;  // Largest free block when the run ended
+    int final_free_units;    // Free units when the run ended
+    double mean_alloc_ns;
+    double p50_alloc_ns;
+    double p99_alloc_ns;
+    double p999_alloc_ns;
+    double mean_free_ns;
+} ChurnResult;
+
+typedef struct {
+    page_key* tags;          // Process and page (or upper-level prefix) of each entry, PAGE_KEY_NONE when empty
+    int* values;             // Frame each entry translates to
+    uint64_t* stamps;        // Last use of each entry, for LRU replacement within a set
+    int sets;
+    int ways;
+    uint64_t clock;
+} TlbArray;
+
+typedef struct {
+    TlbArray base;           // Base-page translations
+    TlbArray huge;           // Huge-page translations, one per page-directory leaf
+    TlbArray walk_cache[PAGE_TABLE_LEVELS - 1]; // Upper-level entries, root first, that let a walk skip levels
+} Mmu;
+
+typedef struct {
+    uint32_t process_id;     // Process issuing the reference
+    uint32_t page_number;    // Virtual page referenced
+    uint8_t write;           // 1 for a write reference, 0 for a read
+} TraceRecord;
+
+typedef struct {
+    TraceRecord* records;    // Reference string, in issue order
+    size_t count;            // Number of records in use
+    size_t capacity;         // Number of records allocated
+} Trace;
+
+typedef struct {
+    size_t references;       // Length of the generated trace
+    int pages;               // Pages each process can touch
+    int processes;           // Processes of the interleaved workload
+    double write_ratio;      // Share of references that write
+    double zipf_theta;       // Skew of Zipfian popularity (0.99 as in YCSB)
+    uint64_t seed;           // Same seed, same trace
+} WorkloadParams;
+
+typedef struct {
+    const char* name;
+    const char* description;
+    int (*generate)(Trace* trace, const WorkloadParams* params); // Appends params->references records
+} WorkloadGenerator;
+
+typedef struct {
+    int pages;
+    double theta;
+    double zeta_n;           // Sum of 1/i^theta over all pages
+    double alpha;
+    double eta;
+    int* rank_page;          // Page given each popularity rank
+} ZipfSampler;
+
+typedef struct {
+    long long stores;        // Pages the tier took on their way to swap
+    long long rejects;       // Pages that did not compress below a page and went straight to disk
+    long long hits;          // Swap-ins served from the tier
+    long long misses;        // Swap-ins that had to go to disk
+    long long writebacks;    // Pages written to disk to make room, oldest first
+    long long bytes_in;      // Uncompressed bytes stored
+    long long bytes_stored;  // Compressed bytes stored
+    double compress_ns;      // Measured CPU time compressing
+    double decompress_ns;    // Measured CPU time decompressing
+} CompressedPoolStats;
+
+typedef struct {
+    long long references;    // References replayed
+    long long page_faults;   // References that missed in memory
+    long long writebacks;    // Dirty pages evicted
+    double elapsed_us;       // Wall-clock time of the replacement loop
+    double virtual_time_us;  // Simulated time until the last reference completed
+    double mean_latency_us;  // Simulated mean reference latency
+    double p50_latency_us;   // Simulated latency percentiles
+    double p99_latency_us;
+    double p999_latency_us;
+    long long device_reads;  // Page reads issued to the swap device
+    long long device_writes; // Dirty page writebacks issued to the swap device
+    CompressedPoolStats tier; // Compressed swap tier activity, all zero without a tier
+} ReplayResult;
+
+typedef struct {
+    const char* name;
+    double command_ns;       // Fixed per-request latency of the device
+    double seek_ns;          // Average seek plus rotational delay; 0 for flash
+    double transfer_ns_per_kb; // Media transfer time per KB
+    int queue_depth;         // Requests the device services in parallel
+} DeviceModel;
+
+typedef struct {
+    int fd;                  // Swap file descriptor, -1 when real page data is off
+    int direct;              // Opened with O_DIRECT, bypassing the page cache
+    size_t page_bytes;       // Bytes per page image and per swap slot
+    unsigned char* cluster;  // Page images waiting to be written, SWAP_CLUSTER_PAGES at most
+    int* cluster_slots;      // Swap slot of each waiting image
+    int cluster_count;
+    int cluster_capacity;
+    struct iovec* vectors;   // Scratch vector for one coalesced write
+    long long pages_read;
+    long long pages_written;
+    double read_ns;          // Measured time spent in pread
+    double write_ns;         // Measured time spent in pwritev
+    struct LatencyHistogram* read_latency;  // Per-operation latency of reads
+    struct LatencyHistogram* write_latency; // Per-operation latency of coalesced writes
+} SwapFile;
+
+typedef struct {
+    const DeviceModel* device; // Swap device faults are served from
+    double dram_hit_ns;      // Cost of a reference that hits in memory
+    double fault_overhead_ns; // CPU cost of taking a fault, before the device is involved
+    int page_kb;             // Page size moved per fault
+    int queue_depth;         // Device queue depth, normally the device's own
+    SwapFile* swap_file;     // When set, evicted pages are written to and faults read from this file
+    size_t compressed_pool_bytes; // Size of a compressed swap tier in front of the device, 0 for none
+    double compress_ns_per_kb; // Modeled CPU cost of compressing, for the virtual clock
+    double decompress_ns_per_kb; // Modeled CPU cost of decompressing
+} TimingModel;
+
+typedef struct {
+    double* free_at;         // Min-heap of the virtual times each device channel becomes idle
+    int channels;            // Queue depth
+    double service_ns;       // Time one page transfer occupies a channel
+    long long reads;         // Transfers submitted as reads
+    long long writes;        // Transfers submitted as writes
+} DeviceQueue;
+
+typedef struct LatencyHistogram {
+    long long counts[LATENCY_BUCKETS]; // Samples per log-linear bucket
+    long long total;         // Samples recorded
+    double sum_ns;           // Sum of all samples
+} LatencyHistogram;
+
+typedef struct {
+    page_key* keys;          // Open-addressing slots, PAGE_KEY_NONE when empty
+    int* values;             // Frame index stored for each slot
+    size_t mask;             // Slot count minus one (slot count is a power of two)
+    size_t count;            // Number of pages stored
+} PageIndex;
+
+// Content-based page merging in the manner of Linux KSM: pages are hashed as the scanner passes
+// them, and identical pages of different processes are mapped onto one shared frame
+typedef struct {
+    int pages_per_check;     // Frames scanned at each load control interval of a process run, 0 for none
+    int cursor;              // Next frame to scan
+    PageIndex stable;        // Content hash -> shared frame, for pages already merged
+    PageIndex unstable;      // Content hash -> private frame seen unchanged this pass; emptied every pass
+    page_key* checksums;     // Per frame: content hash at its last scan, so pages still being written are skipped
+    long long passes;        // Full passes over the frame table
+    long long scanned;       // Pages hashed
+    long long volatile_pages; // Pages skipped because they changed since the last pass
+    long long merged;        // Mappings moved onto a shared frame
+    double cpu_ns;           // Thread CPU time spent scanning
+} PageScanner;
+
+typedef struct {
+    int* prev;               // Neighbour towards the most-recently-used end, -1 at the head
+    int* next;               // Neighbour towards the least-recently-used end, -1 at the tail
+    int head;                // Most recently used node
+    int tail;                // Least recently used node
+    int size;                // Number of linked nodes
+} RecencyList;
+
+typedef struct {
+    int* heap;               // Frames in binary min-heap order
+    int* position;           // Heap slot of each frame, -1 when absent
+    long long* primary;      // First sort key of each frame
+    long long* secondary;    // Tie-breaking sort key of each frame
+    int size;                // Number of frames in the heap
+} FrameHeap;
+
+typedef struct {
+    page_key* keys;          // Page remembered in each slot
+    int* free_slots;         // Stack of unused slots
+    int free_count;          // Number of unused slots
+    PageIndex index;         // Page -> slot
+    RecencyList order;       // Slots from most to least recently evicted
+} GhostList;
+
+// Structure-of-arrays frame table of the replacement loop, laid out for vector compares
+typedef struct {
+    page_key* keys;          // Page held by each frame, PAGE_KEY_NONE when empty
+    int32_t* owners;         // Process owning each frame, -1 when empty
+    uint8_t* flags;          // FRAME_DIRTY / FRAME_REFERENCED bits of each frame
+    int count;               // Number of frames
+} FrameTable;
+
+typedef struct {
+    const char* name;
+    int (*find_key)(const page_key* keys, int count, page_key key);
+    int (*find_flag_clear)(const uint8_t* flags, int start, int end, uint8_t flag);
+    int (*count_owner)(const int32_t* owners, int count, int32_t owner);
+} FrameTableKernels;
+
+typedef struct {
+    int frame_count;         // Number of frames managed by the policy
+    const page_key* frames;  // Page held by each frame, PAGE_KEY_NONE when empty
+    FrameTable* table;       // Frame table the frames array belongs to
+    PageIndex index;         // Resident page -> frame, maintained by the replacement loop
+    const Trace* trace;      // Whole reference string, for offline policies
+    int page_shift;          // Trace pages per simulated page, as a power of two
+    void* data;              // Policy-private state
+} PolicyState;
+
+// Replacement policy hooks. The replacement loop calls lookup on every reference, touch after a hit
+// (inserted = 0) or after filling a frame (inserted = 1), and victim when a fault finds no free
+// frame. victim must unlink the frame it returns from the policy's own structures.
+typedef struct {
+    const char* name;
+    int (*init)(PolicyState* state);
+    int (*lookup)(PolicyState* state, page_key page, size_t position);
+    int (*victim)(PolicyState* state, page_key page, size_t position);
+    void (*touch)(PolicyState* state, int frame, size_t position, int inserted);
+    void (*destroy)(PolicyState* state);
+} ReplacementPolicy;
+
+typedef struct {
+    const ReplacementPolicy* policy;
+    int frame_count;
+    int page_kb;
+    ReplayResult result;
+    int status;              // replay_trace return code, -1 until the cell has run
+} SweepCell;
+
+typedef struct {
+    const Trace* trace;      // Shared read-only by every worker
+    const TimingModel* timing;
+    SweepCell* cells;
+    int cell_count;
+    int next_cell;           // Next unclaimed cell, advanced atomically by the workers
+} SweepQueue;
+
+typedef struct {
+    page_key key;            // Page held, PAGE_KEY_NONE when free; changed only under the frame lock
+    uint8_t lock;            // 1 while a thread fills, evicts or releases the frame
+    uint8_t referenced;      // CLOCK bit, set without the lock on hits
+    uint8_t dirty;
+} SharedFrame;
+
+typedef struct {
+    pthread_mutex_t lock;
+    int* free_slots;         // Stack of the stripe's free swap slots
+    int free_count;
+} SwapStripe;
+
+typedef struct {
+    long long hits;
+    long long faults;
+    long long major_faults;  // Faults on pages that were in a swap slot
+    long long evictions;
+    long long writebacks;    // Dirty victims given a swap slot
+    long long clock_steps;   // Frames the CLOCK hand passed over while evicting
+    long long free_list_retries; // Failed compare-and-swaps on the free-frame stack
+    long long frame_lock_misses; // Frames found locked by another thread
+    long long stale_entries; // Page table entries whose frame was evicted after being read
+    long long stripe_contended; // Swap stripe locks found held by another thread
+    long long stripe_acquisitions;
+} ConcurrentStats;
+
+typedef struct {
+    SharedFrame* frames;
+    int32_t* next;           // Free-frame stack links
+    uint64_t free_head;      // Tag in the high 32 bits, top frame (-1 if empty) in the low 32 bits
+    uint64_t hand;           // CLOCK hand, advanced atomically by evicting threads
+    int frame_count;
+    int** page_tables;       // Per process: frame, PAGE_UNMAPPED or a swap slot entry
+    uint32_t** streams;      // Per process: page in the low 31 bits, write flag in the top bit
+    size_t stream_length;    // References in each stream
+    int pages;               // Pages of each process
+    int process_count;
+    SwapStripe* stripes;     // Swap slots striped by process so swap-out rarely serialises
+    int stripe_count;
+    int slots_per_stripe;
+    int go;                  // Set once every thread exists, so they start together
+    pthread_barrier_t round_barrier; // Every thread finishes a quantum round before any starts the next
+} FramePool;
+
+typedef struct {
+    FramePool* pool;
+    int first_process;       // The thread runs processes first_process, first_process + stride, ...
+    int process_stride;
+    ConcurrentStats stats;   // Kept per thread and summed after the run, so counting never contends
+} ConcurrentWorker;
+
+typedef struct {
+    const char* kind;        // "replacement" or "allocation"
+    const char* workload;
+    const char* path;        // Policy or allocator name
+    long long operations;
+    double throughput;       // Operations per second of wall time
+    double fault_rate;       // Page faults per reference, or failed allocations per allocation
+    double virtual_ms;       // Simulated run time (replacement only)
+    double p50_us;           // Simulated reference latency, or measured allocation latency
+    double p99_us;
+    double p999_us;
+} BenchRow;
+
+typedef struct {
+    size_t capacity_bytes;   // Most compressed bytes the tier may hold
+    size_t used_bytes;       // Compressed bytes held
+    size_t page_bytes;
+    PageIndex index;         // Swap slot -> entry
+    unsigned char** data;    // Compressed image of each entry
+    uint32_t* sizes;         // Compressed size of each entry
+    int* slots;              // Swap slot of each entry
+    int* prev;               // LRU list links; head is the newest page
+    int* next;               // Also chains free entries
+    int head;
+    int tail;
+    int free_entry;          // First released entry, -1 if none
+    int entry_count;         // Entries handed out at least once
+    int entry_capacity;
+    int count;               // Pages held
+    unsigned char* compressed; // Scratch output of the compressor
+    unsigned char* page;     // Scratch page for writeback
+    SwapFile* backing;       // Where written-back pages go; NULL to only count them
+    CompressedPoolStats stats;
+} CompressedPool;
+
+typedef struct {
+    SwapFile* file;          // Swap file holding page contents, or NULL to model the disk only
+    CompressedPool pool;     // Compressed tier in front of the disk; capacity 0 when off
+    size_t page_bytes;
+    long long mismatches;    // Pages brought back with the wrong stamp
+    unsigned char* frame_data; // One page image per frame
+    PageIndex slots;         // Swapped-out page -> swap slot
+    uint64_t* used_slots;    // Bit i is set while swap slot i holds a page
+    int slot_words;          // Number of 64-bit words in the slot bitmap
+    int cursor;              // Next slot to try; allocation moves forward so victims land in adjacent slots
+} ReplaySwap;
+
+typedef struct {
+    long long* misses;       // Misses for a cache of i frames, i = 0..max_frames
+    int max_frames;          // Largest cache size on the curve; larger caches only take cold misses
+    long long references;    // References tracked (all of them unless sampled)
+    long long cold_misses;   // First references to a page
+    long long distinct_pages; // Distinct pages, scaled back up when sampled
+} MissRatioCurve;
+
+Arena sim_arena;              // Frame table, process table and swap slots, sized from the configuration
+DiskPool disk;                // Disk storage, grows as pages are swapped out
 int total_frames, page_size, process_count;
 int disk_page_count = 0;      // Keeps track of how many pages are currently on the disk
-MemoryStats stats = {0, 0};   // Initialize page_faults and swap_time
+MemoryStats stats = {0, 0, 0, 0, 0}; // Initialize page_faults, swap_time and readahead counters
+TimingModel timing_model;     // Device the interactive swap path charges its transfers to
+SwapFile swap_file = {-1};    // Optional swap file holding real page contents
+unsigned char* frame_data;    // Page image of every frame while pages carry real data
+size_t page_image_bytes;      // Bytes per page image in frame_data
+CompressedPool compressed_pool; // Optional compressed tier in front of the swap file
+FrameAllocator frame_allocator; // Free-frame bitmap for the frames passed to allocate_memory
+SlabAllocator slab_allocator; // Size-class caches for small objects, carved from whole frames
+Mmu mmu;                      // TLBs and page-walk caches of the interactive simulator
+LoadControl load_control = {1, WORKING_SET_WINDOW}; // Working-set admission and thrashing control
+int paging_messages = 1;      // Print each swap; off while a process run issues many references
+PageScanner page_scanner;     // Merges identical pages when pages carry real data
+Telemetry telemetry;          // Samples of utilization, faults and swap traffic taken as references are made
+Probe probe;                  // Measures the simulator's own cost per phase when enabled
+const FrameTableKernels* frame_table_kernels; // Compare kernels picked by select_frame_table_kernels
+extern const FrameTableKernels scalar_kernels;
 
 // Function prototypes
 void initialize_frames(Frame* frames, int total_frames);
-void initialize_disk(DiskPage* disk, int max_disk_pages);
+void initialize_disk(DiskPool* pool, Arena* arena);
+int arena_init(Arena* arena, size_t block_size);
+void* arena_alloc(Arena* arena, size_t bytes);
+void arena_release(Arena* arena);
+DiskPage* disk_page(DiskPool* pool, int slot);
+int disk_pool_alloc_slot(DiskPool* pool);
+void disk_pool_free_slot(DiskPool* pool, int slot);
+int frame_allocator_init(FrameAllocator* allocator, int total_frames);
+int frame_allocator_alloc(FrameAllocator* allocator, int count, int* allocated);
+void frame_allocator_free(FrameAllocator* allocator, int frame);
+void frame_allocator_destroy(FrameAllocator* allocator);
+int slab_allocator_init(SlabAllocator* allocator, size_t page_bytes);
+int slab_size_class(const SlabAllocator* allocator, int size);
+int slab_alloc(SlabAllocator* allocator, Frame* frames, int size, SlabObject* object);
+void slab_free(SlabAllocator* allocator, Frame* frames, const SlabObject* object);
+void slab_report(const SlabAllocator* allocator);
+void slab_allocator_free(SlabAllocator* allocator);
+void free_process_objects(Process* process, Frame* frames);
+void allocate_small_objects(Process* processes, int process_count, Frame* frames);
+void free_small_objects(Process* processes, int process_count, Frame* frames);
+int frame_allocator_largest_run(const FrameAllocator* allocator);
+int frame_allocator_free_run_end(const FrameAllocator* allocator, int frame);
+int frame_allocator_alloc_run(FrameAllocator* allocator, int count);
+int mmu_init(Mmu* unit, int entries, int ways, int huge_entries);
+void mmu_free(Mmu* unit);
+int mmu_translate(Process* process, Frame* frames, int index);
+void mmu_invalidate(Process* process, Frame* frames, int index);
+void mmu_flush_process(Mmu* unit, int process_id);
+void map_huge_pages(Process* processes, int process_count, Frame* frames);
+extern const ContiguousAllocator contiguous_allocators[];
+extern const int contiguous_allocator_count;
+int run_allocation_churn(const ContiguousAllocator* allocator, int total_units, long long operations,
+                         double target_utilization, uint64_t seed, ChurnResult* result);
+int run_allocation_benchmark(int argc, char* argv[]);
 void allocate_memory(Process* processes, int process_count, Frame* frames, int total_frames, int page_size);
 void display_memory_map(Frame* frames, int total_frames);
 void deallocate_memory(Frame* frames, int total_frames, Process* processes, int process_count, int process_id);
 int required_pages(int memory_requirement, int page_size);
 void display_processes(Process* processes, int process_count);
 void request_additional_memory(Process* processes, int process_count, Frame* frames, int total_frames, int page_size);
-void print_memory_usage(Frame* frames, int total_frames, int page_size);
-void swap_out_page(Frame* frames, int total_frames, int process_id, int page_number);
-void swap_in_page(int process_id, int page_number);
+void print_memory_usage(Frame* frames, int total_frames, int page_size, Process* processes, int process_count);
+int telemetry_open(Telemetry* log, const char* path, long long interval);
+void telemetry_sample(Telemetry* log);
+void telemetry_close(Telemetry* log);
+int swap_out_page(Frame* frames, Process* process, int page_number);
+int swap_in_page(Frame* frames, Process* process, int page_number);
+Process* find_process(Process* processes, int process_count, int process_id);
+int resize_page_table(Frame* frames, Process* process, int pages);
+int allocate_process_memory(Process* processes, int process_count, Process* process, Frame* frames, int page_size);
+void access_page(Process* processes, int process_count, Frame* frames);
+int reference_page(Process* processes, int process_count, Frame* frames, Process* process, int page_number, int write);
+int working_set_size(const Process* process);
+int reclaim_frame(Process* processes, int process_count, Frame* frames, const Process* requester, int working_set_only);
+void suspend_process(Frame* frames, Process* process);
+void admit_waiting_processes(Process* processes, int process_count, Frame* frames, int page_size);
+void load_control_check(Process* processes, int process_count, Frame* frames, int page_size);
+void run_processes(Process* processes, int process_count, Frame* frames, int page_size);
+void write_page(Process* processes, int process_count, Frame* frames);
+void fork_process(Process* processes, int process_count, Frame* frames);
+int page_scanner_init(PageScanner* scanner, int total_frames, int pages_per_check);
+void page_scanner_scan(Process* processes, int process_count, Frame* frames, int pages);
+void page_scanner_free(PageScanner* scanner);
+void merge_identical_pages(Process* processes, int process_count, Frame* frames);
 void get_memory_status(long long *phys_mem, long long *page_mem);
 void print_numbers();
 void system_memory();
+int read_process_memory(long long* rss_kb, long long* peak_kb, long long* size_kb);
+void probe_init(void);
+void probe_read(ProbeSample* sample);
+int probe_enter(int phase);
+void probe_leave(int previous);
+void probe_report(void);
+void probe_close(void);
 int performance_matrix();
-int main() {
+page_key make_page_key(uint32_t process_id, uint32_t page_number);
+int trace_append(Trace* trace, uint32_t process_id, uint32_t page_number, uint8_t write);
+int trace_load(const char* path, Trace* trace);
+void trace_free(Trace* trace);
+int trace_write(const Trace* trace, const char* path);
+uint64_t workload_random(uint64_t* state);
+int zipf_init(ZipfSampler* zipf, int pages, double theta, uint64_t* rng);
+int zipf_next(const ZipfSampler* zipf, uint64_t* rng);
+void zipf_free(ZipfSampler* zipf);
+extern const WorkloadGenerator workload_generators[];
+extern const int workload_generator_count;
+const WorkloadGenerator* find_workload(const char* name);
+int generate_workload(const WorkloadGenerator* generator, const WorkloadParams* params, Trace* trace);
+void workload_params_defaults(WorkloadParams* params);
+int parse_workload_option(int argc, char* argv[], int i, WorkloadParams* params);
+int run_workload_generate(int argc, char* argv[]);
+int run_benchmark_suite(int argc, char* argv[]);
+int replay_trace(const Trace* trace, int frame_count, const ReplacementPolicy* policy, const TimingModel* timing, int page_shift, ReplayResult* result);
+int run_sweep(int argc, char* argv[]);
+int run_concurrent_simulation(int argc, char* argv[]);
+const DeviceModel* find_device_model(const char* name);
+void timing_model_defaults(TimingModel* timing);
+double device_service_ns(const TimingModel* timing);
+int device_queue_init(DeviceQueue* queue, const TimingModel* timing);
+double device_queue_submit(DeviceQueue* queue, double now, int write);
+void device_queue_free(DeviceQueue* queue);
+void latency_histogram_record(LatencyHistogram* histogram, double latency_ns);
+double latency_histogram_percentile(const LatencyHistogram* histogram, double percentile);
+int parse_timing_option(int argc, char* argv[], int i, TimingModel* timing);
+int swap_file_open(SwapFile* swap, const char* path, size_t page_bytes);
+int swap_file_write(SwapFile* swap, int slot, const void* data);
+int swap_file_read(SwapFile* swap, int slot, void* data);
+int swap_file_read_batch(SwapFile* swap, const int* slots, unsigned char* const* pages, int count);
+double device_batch_ns(const TimingModel* timing, int pages);
+int swap_file_flush(SwapFile* swap);
+void swap_page_fill(unsigned char* data, size_t page_bytes, page_key page);
+int swap_page_verify(const unsigned char* data, size_t page_bytes, page_key page);
+int lz_compress(const unsigned char* source, size_t length, unsigned char* destination, size_t capacity);
+int lz_decompress(const unsigned char* source, size_t length, unsigned char* destination, size_t capacity);
+int compressed_pool_init(CompressedPool* pool, size_t capacity_bytes, size_t page_bytes, SwapFile* backing);
+int compressed_pool_store(CompressedPool* pool, int slot, const unsigned char* data);
+int compressed_pool_load(CompressedPool* pool, int slot, unsigned char* data);
+void compressed_pool_drop(CompressedPool* pool, int slot);
+void compressed_pool_report(const CompressedPoolStats* stats, double device_ns);
+void compressed_pool_free(CompressedPool* pool);
+void swap_file_report(const SwapFile* swap);
+void swap_file_close(SwapFile* swap);
+void select_frame_table_kernels();
+int frame_table_init(FrameTable* table, int count);
+void frame_table_free(FrameTable* table);
+int run_lookup_benchmark();
+const ReplacementPolicy* find_policy(const char* name);
+extern const ReplacementPolicy replacement_policies[];
+extern const int replacement_policy_count;
+int page_index_init(PageIndex* index, size_t expected);
+int page_index_find(const PageIndex* index, page_key key);
+void page_index_insert(PageIndex* index, page_key key, int value);
+int page_index_grow(PageIndex* index);
+void page_index_remove(PageIndex* index, page_key key);
+void page_index_clear(PageIndex* index);
+void page_index_free(PageIndex* index);
+int recency_list_init(RecencyList* list, int capacity);
+void recency_list_push_front(RecencyList* list, int node);
+void recency_list_remove(RecencyList* list, int node);
+void recency_list_free(RecencyList* list);
+int frame_heap_init(FrameHeap* heap, int capacity);
+void frame_heap_update(FrameHeap* heap, int frame, long long primary, long long secondary);
+void frame_heap_free(FrameHeap* heap);
+int ghost_list_init(GhostList* ghost, int capacity);
+int ghost_list_contains(const GhostList* ghost, page_key key);
+void ghost_list_remove(GhostList* ghost, page_key key);
+void ghost_list_drop_oldest(GhostList* ghost);
+void ghost_list_push(GhostList* ghost, page_key key);
+void ghost_list_free(GhostList* ghost);
+int run_trace_replay(int argc, char* argv[]);
+int run_lru_benchmark();
+int compute_miss_ratio_curve(const Trace* trace, double sample_rate, MissRatioCurve* curve);
+int write_miss_ratio_curve(const MissRatioCurve* curve, const char* path);
+int run_miss_ratio_curve(int argc, char* argv[]);
+int run_command_line(int argc, char* argv[]);
+int main(int argc, char* argv[]) {
+    select_frame_table_kernels();
+    timing_model_defaults(&timing_model);
+
+    // "--swap-file PATH" and "--zswap-mb N" keep the interactive menu but give pages real data,
+    // swapped to a file and/or a compressed tier; any other arguments select a batch mode
+    const char* swap_path = NULL;
+    double zswap_mb = 0;
+    int tlb_entries = TLB_ENTRIES, tlb_ways = TLB_WAYS, huge_tlb_entries = HUGE_TLB_ENTRIES;
+    int ksm_pages = 0;
+    const char* telemetry_path = NULL;
+    long long telemetry_interval = TELEMETRY_INTERVAL;
+    int interactive = argc % 2 == 1;
+    for (int i = 1; i + 1 < argc && interactive; i += 2) {
+        if (strcmp(argv[i], "--swap-file") == 0) {
+            swap_path = argv[i + 1];
+        } else if (strcmp(argv[i], "--zswap-mb") == 0) {
+            zswap_mb = atof(argv[i + 1]);
+        } else if (strcmp(argv[i], "--tlb-entries") == 0) {
+            tlb_entries = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--tlb-ways") == 0) {
+            tlb_ways = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--huge-tlb-entries") == 0) {
+            huge_tlb_entries = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--ws-window") == 0) {
+            load_control.window = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--load-control") == 0) {
+            load_control.enabled = strcmp(argv[i + 1], "off") != 0;
+        } else if (strcmp(argv[i], "--ksm-pages") == 0) {
+            ksm_pages = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--telemetry") == 0) {
+            telemetry_path = argv[i + 1];
+        } else if (strcmp(argv[i], "--telemetry-interval") == 0) {
+            telemetry_interval = atoll(argv[i + 1]);
+        } else {
+            interactive = 0;
+        }
+    }
+    if (!interactive) {
+        return run_command_line(argc, argv);
+    }
+
     system_memory();
+    probe_init();
 
     char continue_input = 'y';
 
@@ -76,17 +894,23 @@ int main() {
     scanf("%d", &total_frames);
     printf("Enter page size (in KB): ");
     scanf("%d", &page_size);
-    printf("Enter number of processes (max %d): ", MAX_PROCESSES);
+    printf("Enter number of processes: ");
     scanf("%d", &process_count);
 
-    if (process_count > MAX_PROCESSES || total_frames > MAX_FRAMES) {
-        printf("Error: Maximum limits exceeded. Please enter values within the limits.\n");
+    if (process_count <= 0 || total_frames <= 0 || page_size <= 0 || load_control.window <= 0 || ksm_pages < 0 ||
+        telemetry_interval <= 0) {
+        printf("Error: Frames, page size, processes, the working-set window and the telemetry interval must all be "
+               "greater than 0, and pages scanned for merging not negative.\n");
         return 1;
     }
 
-    // Allocate memory for frames and processes
-    Frame* frames = (Frame*)malloc(total_frames * sizeof(Frame));
-    Process* processes = (Process*)malloc(process_count * sizeof(Process));
+    // Allocate memory for frames and processes from one arena sized for both
+    size_t table_bytes = (size_t)total_frames * sizeof(Frame) + (size_t)process_count * sizeof(Process) + 2 * ARENA_ALIGNMENT;
+    if (arena_init(&sim_arena, table_bytes) != 0) {
+        return 1;
+    }
+    Frame* frames = (Frame*)arena_alloc(&sim_arena, (size_t)total_frames * sizeof(Frame));
+    Process* processes = (Process*)arena_alloc(&sim_arena, (size_t)process_count * sizeof(Process));
 
     // Check for successful memory allocation
     if (frames == NULL || processes == NULL) {
@@ -96,7 +920,36 @@ int main() {
 
     // Initialize frames and disk
     initialize_frames(frames, total_frames);
-    initialize_disk(disk, MAX_DISK_PAGES);
+    initialize_disk(&disk, &sim_arena);
+    if (frame_allocator_init(&frame_allocator, total_frames) != 0) {
+        return 1;
+    }
+    slab_allocator_init(&slab_allocator, (size_t)page_size * 1024);
+    if (mmu_init(&mmu, tlb_entries, tlb_ways, huge_tlb_entries) != 0) {
+        return 1;
+    }
+    if (telemetry_path != NULL && telemetry_open(&telemetry, telemetry_path, telemetry_interval) != 0) {
+        return 1;
+    }
+    timing_model.page_kb = page_size;
+    // Page merging compares page contents, so it gives pages real data too
+    if (swap_path != NULL || zswap_mb > 0 || ksm_pages > 0) {
+        page_image_bytes = (size_t)page_size * 1024;
+        if (posix_memalign((void**)&frame_data, 4096, (size_t)total_frames * page_image_bytes) != 0) {
+            printf("Error: Memory allocation failed.\n");
+            return 1;
+        }
+        if (swap_path != NULL && swap_file_open(&swap_file, swap_path, page_image_bytes) != 0) {
+            return 1;
+        }
+        if (zswap_mb > 0 && compressed_pool_init(&compressed_pool, (size_t)(zswap_mb * 1024 * 1024), page_image_bytes,
+                                                 swap_file.fd >= 0 ? &swap_file : NULL) != 0) {
+            return 1;
+        }
+        if (page_scanner_init(&page_scanner, total_frames, ksm_pages) != 0) {
+            return 1;
+        }
+    }
 
     // Step 2: Input each process's memory requirements
     for (int i = 0; i < process_count; i++) {
@@ -105,6 +958,26 @@ int main() {
         scanf("%d", &processes[i].memory_requirement);
         processes[i].allocated = 0; // Initially set allocation status to false
         processes[i].state = WAITING; // Set initial state to WAITING
+        processes[i].page_table = NULL;
+        processes[i].page_table_size = 0;
+        processes[i].resident_pages = 0;
+        processes[i].mapped_pages = 0;
+        processes[i].huge_regions = 0;
+        processes[i].last_fault_page = 0;
+        processes[i].fault_stride = 0;
+        processes[i].readahead_window = READAHEAD_MIN_PAGES;
+        processes[i].last_use = NULL;
+        processes[i].virtual_time = 0;
+        processes[i].faults = 0;
+        processes[i].working_set = 0;
+        processes[i].deferred = 0;
+        processes[i].queued_at = 0;
+        processes[i].admitted_at = 0;
+        processes[i].objects = NULL;
+        processes[i].object_count = 0;
+        processes[i].object_capacity = 0;
+        processes[i].object_bytes_requested = 0;
+        processes[i].object_bytes_consumed = 0;
     }
 
     // Allocate memory for processes
@@ -121,7 +994,15 @@ int main() {
         printf("6. Display Memory Usage Statistics and fragmentation\n");
         printf("7. Display Performance Matrix\n");
         printf("8. Exit\n");
-        printf("Choose an option (1-7): ");
+        printf("9. Access a Process Page\n");
+        printf("10. Allocate Small Objects\n");
+        printf("11. Free Small Objects\n");
+        printf("12. Map Huge Pages\n");
+        printf("13. Run Processes\n");
+        printf("14. Write a Process Page\n");
+        printf("15. Fork a Process\n");
+        printf("16. Merge Identical Pages\n");
+        printf("Choose an option (1-16): ");
         int option;
         scanf("%d", &option);
 
@@ -131,6 +1012,7 @@ int main() {
                 printf("Enter process ID to deallocate memory: ");
                 scanf("%d", &pid_to_deallocate);
                 deallocate_memory(frames, total_frames, processes, process_count, pid_to_deallocate);
+                admit_waiting_processes(processes, process_count, frames, page_size); // Freed frames may let one in
                 display_memory_map(frames, total_frames);
                 break;
             }
@@ -154,7 +1036,7 @@ int main() {
                 display_memory_map(frames, total_frames);
                 break;
             case 6:
-                print_memory_usage(frames, total_frames, page_size);
+                print_memory_usage(frames, total_frames, page_size, processes, process_count);
                 break;
             case 7:
                 performance_matrix();
@@ -162,16 +1044,68 @@ int main() {
             case 8:
                 continue_input = 'n'; // Exit the loop
                 break;
+            case 9:
+                access_page(processes, process_count, frames);
+                display_memory_map(frames, total_frames);
+                break;
+            case 10:
+                allocate_small_objects(processes, process_count, frames);
+                break;
+            case 11:
+                free_small_objects(processes, process_count, frames);
+                break;
+            case 12:
+                map_huge_pages(processes, process_count, frames);
+                display_memory_map(frames, total_frames);
+                break;
+            case 13:
+                run_processes(processes, process_count, frames, page_size);
+                break;
+            case 14:
+                write_page(processes, process_count, frames);
+                display_memory_map(frames, total_frames);
+                break;
+            case 15:
+                fork_process(processes, process_count, frames);
+                display_memory_map(frames, total_frames);
+                break;
+            case 16:
+                merge_identical_pages(processes, process_count, frames);
+                display_memory_map(frames, total_frames);
+                break;
             default:
                 printf("Invalid option. Please choose again.\n");
                 break;
         }
     }
 
+    performance_matrix(); // Before the free-frame bitmap it measures fragmentation from is released
+    telemetry_close(&telemetry);
+    probe_report();
+    probe_close();
+
     // Free allocated memory
-    free(frames);
-    free(processes);
-    performance_matrix();
+    for (int i = 0; i < process_count; i++) {
+        free(processes[i].page_table);
+        free(processes[i].last_use);
+        free(processes[i].objects);
+    }
+    slab_allocator_free(&slab_allocator);
+    page_scanner_free(&page_scanner);
+    mmu_free(&mmu);
+    free(disk.chunks);
+    if (compressed_pool.capacity_bytes > 0) {
+        compressed_pool_report(&compressed_pool.stats, device_service_ns(&timing_model));
+        compressed_pool_free(&compressed_pool);
+    }
+    if (swap_file.fd >= 0) {
+        swap_file_flush(&swap_file);
+        swap_file_report(&swap_file);
+        swap_file_close(&swap_file);
+    }
+    free(frame_data);
+    arena_release(&sim_arena);
+    frame_allocator_destroy(&frame_allocator);
     return 0;
 }
 // calculate system memory before and after a process
@@ -181,19 +1115,12 @@ void system_memory()
     long long phys_mem_after, page_mem_after;
 
     // Get memory status before
-    MEMORYSTATUSEX statex_before;
-    statex_before.dwLength = sizeof(statex_before);
-
-    if (GlobalMemoryStatusEx(&statex_before)) {
-        phys_mem_before = statex_before.ullAvailPhys / 1024;  // Available physical memory in KB
-        page_mem_before = statex_before.ullAvailPageFile / 1024;  // Available paging file memory in KB
-
+    get_memory_status(&phys_mem_before, &page_mem_before);
+    if (phys_mem_before >= 0) {
         printf("Available Physical Memory Before: %lld KB\n", phys_mem_before);
-        printf("Available Paging File Memory Before: %lld KB\n", page_mem_before);
+        printf("Available Swap Memory Before: %lld KB\n", page_mem_before);
     } else {
         printf("Failed to get memory status.\n");
-        phys_mem_before = -1;
-        page_mem_before = -1;
     }
 
     // Allocate and initialize numbers
@@ -206,345 +1133,6725 @@ void system_memory()
         }
         free(numbers);  // Free the allocated memory
     }
-    SYSTEM_INFO sysInfo;
-
-    GetSystemInfo(&sysInfo);
-
-    system_frame_size = sysInfo.dwPageSize;
-    process_used_memory =(1000000 * sizeof(int))/1000;
 
     // Get memory status after
-    MEMORYSTATUSEX statex_after;
-    statex_after.dwLength = sizeof(statex_after);
-
-    if (GlobalMemoryStatusEx(&statex_after)) {
-        phys_mem_after = statex_after.ullAvailPhys / 1024;  // Available physical memory in KB
-        page_mem_after = statex_after.ullAvailPageFile / 1024;  // Available paging file memory in KB
-
+    get_memory_status(&phys_mem_after, &page_mem_after);
+    if (phys_mem_after >= 0) {
         printf("Available Physical Memory After: %lld KB\n", phys_mem_after);
-        printf("Available Paging File Memory After: %lld KB\n", page_mem_after);
+        printf("Available Swap Memory After: %lld KB\n", page_mem_after);
     } else {
         printf("Failed to get memory status.\n");
-        phys_mem_after = -1;
-        page_mem_after = -1;
     }
+}
 
+// Function to read available physical memory and free swap from /proc/meminfo, in KB (-1 if unknown)
+void get_memory_status(long long *phys_mem, long long *page_mem) {
+    *phys_mem = -1;
+    *page_mem = -1;
+    FILE* file = fopen("/proc/meminfo", "r");
+    if (file == NULL) {
+        return;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        sscanf(line, "MemAvailable: %lld kB", phys_mem);
+        sscanf(line, "SwapFree: %lld kB", page_mem);
+    }
+    fclose(file);
 }
 
+// Function to read the simulator's own resident, peak resident and virtual size from
+// /proc/self/status, in KB; returns 1 if the file cannot be read
+int read_process_memory(long long* rss_kb, long long* peak_kb, long long* size_kb) {
+    *rss_kb = *peak_kb = *size_kb = -1;
+    FILE* file = fopen("/proc/self/status", "r");
+    if (file == NULL) {
+        return 1;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        sscanf(line, "VmRSS: %lld kB", rss_kb);
+        sscanf(line, "VmHWM: %lld kB", peak_kb);
+        sscanf(line, "VmSize: %lld kB", size_kb);
+    }
+    fclose(file);
+    return 0;
+}
 
-// Function to initialize all frames as free
-void initialize_frames(Frame* frames, int total_frames) {
-    for (int i = 0; i < total_frames; i++) {
-        frames[i].assigned = 0;
-        frames[i].process_id = -1;
-        frames[i].page_number = -1;
+// Function to open one user-space hardware counter on this thread; -1 if perf events are unavailable
+static int probe_open_counter(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1; // Allowed at the default perf_event_paranoid level
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// Function to start measuring the simulator itself; hardware counters are used where perf allows
+void probe_init(void) {
+    memset(&probe, 0, sizeof(probe));
+    probe.fds[PROBE_CYCLES] = probe_open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    probe.fds[PROBE_CACHE_MISSES] = probe_open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    probe.fds[PROBE_DTLB_MISSES] = probe_open_counter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |
+                                                       (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                       (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    probe.current = PROBE_OTHER;
+    probe.enabled = 1;
+    probe_read(&probe.last);
+}
+
+// Function to take one reading of the clock, rusage and hardware counters
+void probe_read(ProbeSample* sample) {
+    struct timespec now;
+    struct rusage usage;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    getrusage(RUSAGE_SELF, &usage);
+    sample->wall_ns = now.tv_sec * 1e9 + now.tv_nsec;
+    sample->user_us = usage.ru_utime.tv_sec * 1e6 + usage.ru_utime.tv_usec;
+    sample->system_us = usage.ru_stime.tv_sec * 1e6 + usage.ru_stime.tv_usec;
+    sample->minor_faults = usage.ru_minflt;
+    sample->major_faults = usage.ru_majflt;
+    for (int c = 0; c < PROBE_COUNTERS; c++) {
+        uint64_t value = 0;
+        if (probe.fds[c] >= 0 && read(probe.fds[c], &value, sizeof(value)) != sizeof(value)) {
+            value = 0;
+        }
+        sample->counters[c] = (long long)value;
     }
 }
 
-// Function to initialize disk storage
-void initialize_disk(DiskPage* disk, int max_disk_pages) {
-    for (int i = 0; i < max_disk_pages; i++) {
-        disk[i].process_id = -1;
-        disk[i].page_number = -1;
-        disk[i].in_memory = 0;
+// Function to charge everything since the last reading to the running phase and make another
+// phase the running one
+static void probe_charge(int phase) {
+    ProbeSample now;
+    probe_read(&now);
+    ProbeSample* total = &probe.totals[probe.current];
+    total->wall_ns += now.wall_ns - probe.last.wall_ns;
+    total->user_us += now.user_us - probe.last.user_us;
+    total->system_us += now.system_us - probe.last.system_us;
+    total->minor_faults += now.minor_faults - probe.last.minor_faults;
+    total->major_faults += now.major_faults - probe.last.major_faults;
+    for (int c = 0; c < PROBE_COUNTERS; c++) {
+        total->counters[c] += now.counters[c] - probe.last.counters[c];
     }
+    probe.last = now;
+    probe.current = phase;
 }
 
-// Function to calculate required pages based on memory requirement and page size
-int required_pages(int memory_requirement, int page_size) {
-    return (int)ceil((double)memory_requirement / page_size);
+// Function to enter a phase; returns the phase that was running, which probe_leave resumes.
+// Phases are exclusive: swap work inside the replacement loop is charged to swap only.
+int probe_enter(int phase) {
+    if (!probe.enabled) {
+        return phase;
+    }
+    int previous = probe.current;
+    probe_charge(phase);
+    probe.entries[phase]++;
+    return previous;
 }
 
-// Function to allocate memory for processes
-void allocate_memory(Process* processes, int process_count, Frame* frames, int total_frames, int page_size) {
-    for (int i = 0; i < process_count; i++) {
-        int pages_needed = required_pages(processes[i].memory_requirement, page_size);
-        int allocated_pages = 0;
-
-        // Check if there are enough free frames to satisfy the process's memory requirement
-        for (int j = 0; j < total_frames && allocated_pages < pages_needed; j++) {
-            if (frames[j].assigned == 0) {
-                frames[j].assigned = 1;
-                frames[j].process_id = processes[i].process_id;
-                frames[j].page_number = allocated_pages + 1;
-                allocated_pages++;
-            }
-        }
-
-        // If not enough frames are available, swap out pages to disk
-        if (allocated_pages < pages_needed) {
-            for (int j = 0; j < total_frames && allocated_pages < pages_needed; j++) {
-                if (frames[j].assigned == 1 && frames[j].process_id == processes[i].process_id) {
-                    swap_out_page(frames, total_frames, processes[i].process_id, frames[j].page_number);
-                    frames[j].assigned = 0;
-                    frames[j].process_id = -1;
-                    frames[j].page_number = -1;
-                    allocated_pages++;
-                }
+// Function to leave the running phase and resume the one probe_enter returned
+void probe_leave(int previous) {
+    if (probe.enabled) {
+        probe_charge(previous);
+    }
+}
+
+// Function to print where the simulator spent time, faults and hardware events, phase by phase
+void probe_report(void) {
+    if (!probe.enabled) {
+        return;
+    }
+    static const char* phase_names[PROBE_PHASES] = {"other", "trace load", "allocation", "replacement", "swap", "dedup"};
+    probe_charge(probe.current); // Bring the running phase up to date
+    int counters = probe.fds[PROBE_CYCLES] >= 0 || probe.fds[PROBE_CACHE_MISSES] >= 0 || probe.fds[PROBE_DTLB_MISSES] >= 0;
+    printf("\nSimulator cost by phase (%s):\n", counters ? "perf counters in user space" : "perf counters unavailable");
+    printf("+-------------+-----------+------------+------------+------------+------------+------------+----------------+----------------+----------------+\n");
+    printf("| Phase       | Entries   | Wall (ms)  | User (ms)  | Sys (ms)   | Minor Flt  | Major Flt  | Cycles         | Cache Misses   | dTLB Misses    |\n");
+    printf("+-------------+-----------+------------+------------+------------+------------+------------+----------------+----------------+----------------+\n");
+    for (int p = 0; p < PROBE_PHASES; p++) {
+        const ProbeSample* total = &probe.totals[p];
+        if (probe.entries[p] == 0 && p != PROBE_OTHER) {
+            continue;
+        }
+        printf("| %-11s | %9lld | %10.2f | %10.2f | %10.2f | %10lld | %10lld |", phase_names[p], probe.entries[p],
+               total->wall_ns / 1e6, total->user_us / 1000.0, total->system_us / 1000.0,
+               total->minor_faults, total->major_faults);
+        for (int c = 0; c < PROBE_COUNTERS; c++) {
+            if (probe.fds[c] >= 0) {
+                printf(" %14lld |", total->counters[c]);
+            } else {
+                printf(" %14s |", "n/a");
             }
         }
+        printf("\n");
+    }
+    printf("+-------------+-----------+------------+------------+------------+------------+------------+----------------+----------------+----------------+\n");
+    long long rss_kb, peak_kb, size_kb;
+    if (read_process_memory(&rss_kb, &peak_kb, &size_kb) == 0) {
+        printf("Simulator memory: %lld KB resident, %lld KB peak resident, %lld KB virtual\n", rss_kb, peak_kb, size_kb);
+    }
+}
 
-        // Set process allocation status
-        if (allocated_pages == pages_needed) {
-            processes[i].allocated = 1;
-            processes[i].state = RUNNING; // Set state to RUNNING
-            printf("Process %d allocated %d pages\n", processes[i].process_id, pages_needed);
-        } else {
-            printf("Process %d could not be allocated due to insufficient memory\n", processes[i].process_id);
+// Function to stop measuring and close the hardware counters
+void probe_close(void) {
+    for (int c = 0; c < PROBE_COUNTERS; c++) {
+        if (probe.enabled && probe.fds[c] >= 0) {
+            close(probe.fds[c]);
         }
     }
+    probe.enabled = 0;
 }
 
-// Function to swap out a page from RAM to disk
-void swap_out_page(Frame* frames, int total_frames, int process_id, int page_number) {
-    if (disk_page_count < MAX_DISK_PAGES) {
-        disk[disk_page_count].process_id = process_id;
-        disk[disk_page_count].page_number = page_number;
-        disk[disk_page_count].in_memory = 0;
-        disk_page_count++;
-        stats.page_faults++; // Increment page fault count
-        printf("Swapping out page %d of process %d to disk\n", page_number, process_id);
+// Function to initialize all frames as free
+void initialize_frames(Frame* frames, int total_frames) {
+    for (int i = 0; i < total_frames; i++) {
+        frames[i].assigned = 0;
+        frames[i].prefetched = 0;
+        frames[i].huge = 0;
+        frames[i].process_id = -1;
+        frames[i].page_number = -1;
     }
 }
 
-// Function to swap in a page from disk to RAM
-void swap_in_page(int process_id, int page_number) {
-    for (int i = 0; i < disk_page_count; i++) {
-        if (disk[i].process_id == process_id && disk[i].page_number == page_number && !disk[i].in_memory) {
-            disk[i].in_memory = 1; // Mark the page as loaded into memory
-            stats.swap_time += 10; // Simulate swap time for page fault
-            printf("Swapping in page %d of process %d from disk\n", page_number, process_id);
-            break;
+// Function to initialize disk storage; swap slots are added in chunks as pages are swapped out
+void initialize_disk(DiskPool* pool, Arena* arena) {
+    pool->chunks = NULL;
+    pool->chunk_count = 0;
+    pool->chunk_capacity = 0;
+    pool->next_unused = 0;
+    pool->free_head = -1;
+    pool->arena = arena;
+}
+
+// Function to create an arena whose blocks hold at least block_size bytes
+int arena_init(Arena* arena, size_t block_size) {
+    arena->head = NULL;
+    arena->block_size = block_size > 65536 ? block_size : 65536;
+    return 0;
+}
+
+// Function to carve an aligned allocation out of the arena, adding a block when the current one is full
+void* arena_alloc(Arena* arena, size_t bytes) {
+    bytes = (bytes + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    ArenaBlock* block = arena->head;
+    if (block == NULL || block->size - block->used < bytes) {
+        size_t size = bytes > arena->block_size ? bytes : arena->block_size;
+        block = (ArenaBlock*)malloc(sizeof(ArenaBlock) + size + ARENA_ALIGNMENT);
+        if (block == NULL) {
+            return NULL;
         }
+        uintptr_t start = ((uintptr_t)(block + 1) + ARENA_ALIGNMENT - 1) & ~(uintptr_t)(ARENA_ALIGNMENT - 1);
+        block->data = (unsigned char*)start;
+        block->size = size;
+        block->used = 0;
+        block->next = arena->head;
+        arena->head = block;
     }
+    void* memory = block->data + block->used;
+    block->used += bytes;
+    return memory;
 }
 
-// Function to deallocate memory for a process
-void deallocate_memory(Frame* frames, int total_frames, Process* processes, int process_count, int process_id) {
-    for (int i = 0; i < total_frames; i++) {
-        if (frames[i].process_id == process_id) {
-            frames[i].assigned = 0;
-            frames[i].process_id = -1;
-            frames[i].page_number = -1;
-        }
+// Function to free every block of an arena at once
+void arena_release(Arena* arena) {
+    while (arena->head != NULL) {
+        ArenaBlock* next = arena->head->next;
+        free(arena->head);
+        arena->head = next;
     }
-    printf("Memory deallocated for process %d\n", process_id);
 }
 
-// Function to request additional memory
-void request_additional_memory(Process* processes, int process_count, Frame* frames, int total_frames, int page_size) {
-    int process_id, additional_memory;
-    printf("Enter process ID to request additional memory: ");
-    scanf("%d", &process_id);
-    printf("Enter additional memory required (in KB): ");
-    scanf("%d", &additional_memory);
+// Function to find the disk page record of a swap slot
+DiskPage* disk_page(DiskPool* pool, int slot) {
+    return &pool->chunks[slot / DISK_CHUNK_PAGES][slot % DISK_CHUNK_PAGES];
+}
 
-    for (int i = 0; i < process_count; i++) {
-        if (processes[i].process_id == process_id) {
-            processes[i].memory_requirement += additional_memory;
-            allocate_memory(processes, process_count, frames, total_frames, page_size);
-            break;
+// Function to take a swap slot, reusing released slots first; returns -1 if memory runs out
+int disk_pool_alloc_slot(DiskPool* pool) {
+    if (pool->free_head >= 0) {
+        int slot = pool->free_head;
+        pool->free_head = disk_page(pool, slot)->page_number;
+        return slot;
+    }
+    if (pool->next_unused == pool->chunk_count * DISK_CHUNK_PAGES) {
+        if (pool->chunk_count == pool->chunk_capacity) {
+            int capacity = pool->chunk_capacity == 0 ? 16 : pool->chunk_capacity * 2;
+            DiskPage** chunks = (DiskPage**)realloc(pool->chunks, capacity * sizeof(DiskPage*));
+            if (chunks == NULL) {
+                return -1;
+            }
+            pool->chunks = chunks;
+            pool->chunk_capacity = capacity;
         }
+        DiskPage* chunk = (DiskPage*)arena_alloc(pool->arena, DISK_CHUNK_PAGES * sizeof(DiskPage));
+        if (chunk == NULL) {
+            return -1;
+        }
+        pool->chunks[pool->chunk_count++] = chunk;
     }
+    return pool->next_unused++;
 }
 
-// Function to display memory map
-void display_memory_map(Frame* frames, int total_frames) {
-    printf("\nMemory Map:\n");
-    printf("Frame   Status          Process ID      Number of Page\n");
-    printf("-------------------------------------------------\n");
-    for (int i = 0; i < total_frames; i++) {
-        if (frames[i].assigned) {
-            printf("%d       Assigned        %d               %d\n", i+1, frames[i].process_id, frames[i].page_number);
-        } else {
-            printf("%d       Free            N/A             N/A\n", i+1);
+// Function to return a swap slot to the pool
+void disk_pool_free_slot(DiskPool* pool, int slot) {
+    DiskPage* page = disk_page(pool, slot);
+    page->process_id = -1;
+    page->page_number = pool->free_head;
+    pool->free_head = slot;
+}
+
+// Function to recompute the free-run summary of one bitmap word and of every span above it, so
+// the longest free run is always at the root of the tree
+static void frame_allocator_update_runs(FrameAllocator* allocator, int word_index) {
+    uint64_t word = allocator->words[word_index];
+    int node = allocator->run_leaves + word_index;
+    FreeRun* leaf = &allocator->runs[node];
+    leaf->prefix = word == ~0ULL ? 64 : __builtin_ctzll(~word);
+    leaf->suffix = word == ~0ULL ? 64 : __builtin_clzll(~word);
+    // Longest run inside the word: each step shortens every run of ones by one
+    leaf->best = 0;
+    for (uint64_t x = word; x != 0; x &= x >> 1) {
+        leaf->best++;
+    }
+    for (int length = 64; node > 1; node /= 2, length *= 2) {
+        const FreeRun* left = &allocator->runs[node & ~1];
+        const FreeRun* right = &allocator->runs[node | 1];
+        FreeRun* parent = &allocator->runs[node / 2];
+        parent->prefix = left->prefix == length ? length + right->prefix : left->prefix;
+        parent->suffix = right->suffix == length ? length + left->suffix : right->suffix;
+        parent->best = left->suffix + right->prefix;
+        if (left->best > parent->best) {
+            parent->best = left->best;
+        }
+        if (right->best > parent->best) {
+            parent->best = right->best;
         }
     }
-    printf("-------------------------------------------------\n");
 }
 
-// Function to display active processes
-void display_processes(Process* processes, int process_count) {
-    printf("\nActive Processes:\n");
-    for (int i = 0; i < process_count; i++) {
-        printf("Process %d - Memory Required: %d KB, State: %d\n",
-                processes[i].process_id, processes[i].memory_requirement, processes[i].state);
+// Function to initialize the free-frame bitmap with every frame free
+int frame_allocator_init(FrameAllocator* allocator, int total_frames) {
+    allocator->word_count = (total_frames + 63) / 64;
+    allocator->run_leaves = 1;
+    while (allocator->run_leaves < allocator->word_count) {
+        allocator->run_leaves *= 2;
+    }
+    allocator->words = (uint64_t*)malloc((allocator->word_count > 0 ? allocator->word_count : 1) * sizeof(uint64_t));
+    allocator->runs = (FreeRun*)calloc(2 * allocator->run_leaves, sizeof(FreeRun)); // Leaves past the bitmap stay all in use
+    if (allocator->words == NULL || allocator->runs == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        return 1;
     }
+    for (int i = 0; i < allocator->word_count; i++) {
+        allocator->words[i] = ~0ULL;
+    }
+    // Clear the bits past the last frame so they are never handed out
+    if (total_frames % 64 != 0) {
+        allocator->words[allocator->word_count - 1] = (1ULL << (total_frames % 64)) - 1;
+    }
+    for (int i = 0; i < allocator->word_count; i++) {
+        frame_allocator_update_runs(allocator, i);
+    }
+    allocator->total_frames = total_frames;
+    allocator->free_frames = total_frames;
+    allocator->search_hint = 0;
+    return 0;
 }
 
-// Function to print memory usage statistics
-void print_memory_usage(Frame* frames, int total_frames, int page_size) {
-    int used_frames = 0;
-    int free_frames = 0;
-    int total_memory = total_frames * page_size;
-    int used_memory = 0;
-
-    // Calculate used frames, free frames, used memory, and free memory
-    for (int i = 0; i < total_frames; i++) {
-        if (frames[i].assigned) {
-            used_frames++;
-            used_memory += page_size;
+// Function to take up to count free frames, lowest first; returns how many were taken
+int frame_allocator_alloc(FrameAllocator* allocator, int count, int* allocated) {
+    int taken = 0;
+    for (int i = allocator->search_hint; i < allocator->word_count && taken < count; i++) {
+        uint64_t word = allocator->words[i];
+        if (word == 0) {
+            allocator->search_hint = i + 1;
+            continue;
+        }
+        if (__builtin_popcountll(word) <= count - taken) {
+            // The whole word fits in the request: take every free frame in it at once
+            allocator->words[i] = 0;
+            allocator->search_hint = i + 1;
         } else {
-            free_frames++;
+            uint64_t remaining = word;
+            for (int n = count - taken; n > 0; n--) {
+                remaining &= remaining - 1;
+            }
+            allocator->words[i] = remaining;
+            word ^= remaining;
+        }
+        frame_allocator_update_runs(allocator, i);
+        while (word != 0) {
+            allocated[taken++] = i * 64 + __builtin_ctzll(word);
+            word &= word - 1;
         }
     }
+    allocator->free_frames -= taken;
+    return taken;
+}
 
-    int free_memory = total_memory - used_memory;
-    double memory_utilization = ((double)used_memory / total_memory) * 100;
+// Function to return one frame to the free-frame bitmap
+void frame_allocator_free(FrameAllocator* allocator, int frame) {
+    int word = frame / 64;
+    uint64_t bit = 1ULL << (frame % 64);
+    if ((allocator->words[word] & bit) == 0) {
+        allocator->words[word] |= bit;
+        frame_allocator_update_runs(allocator, word);
+        allocator->free_frames++;
+        if (word < allocator->search_hint) {
+            allocator->search_hint = word;
+        }
+    }
+}
 
-    double exf= 100 - ((double)used_memory/total_memory)*100;
-    double inf= 100 - ((double)process_used_memory/system_frame_size)*100;
+// Function to release the free-frame bitmap
+void frame_allocator_destroy(FrameAllocator* allocator) {
+    free(allocator->words);
+    free(allocator->runs);
+    allocator->words = NULL;
+    allocator->runs = NULL;
+}
 
+// Function to give the longest run of free frames in the bitmap, kept at the root of the free-run
+// tree; external fragmentation of the frame pool is how far that falls short of all the free frames
+int frame_allocator_largest_run(const FrameAllocator* allocator) {
+    return allocator->runs[1].best;
+}
 
+// Function to find where the run of free frames starting at a free frame ends: the first frame
+// in use after it, or total_frames
+int frame_allocator_free_run_end(const FrameAllocator* allocator, int frame) {
+    int word_index = frame / 64;
+    uint64_t used = ~allocator->words[word_index] & (~0ULL << (frame % 64));
+    while (used == 0 && ++word_index < allocator->word_count) {
+        used = ~allocator->words[word_index];
+    }
+    int end = used != 0 ? word_index * 64 + __builtin_ctzll(used) : allocator->total_frames;
+    return end < allocator->total_frames ? end : allocator->total_frames;
+}
 
-    // Display memory usage statistics
-    printf("\nMemory Usage Statistics:\n");
-    printf("Total Frames: %d\n", total_frames);
-    printf("Used Frames: %d\n", used_frames);
-    printf("Free Frames: %d\n", free_frames);
-    printf("Total Memory: %d KB\n", total_memory);
-    printf("Used Memory: %d KB\n", used_memory);
-    printf("Free Memory: %d KB\n", free_memory);
-    printf("External Fragmentation: %.2lf %%\n",exf);
-    printf("Internal Fragmentation: %.2lf %%\n",inf);
-    printf("Memory Utilization: %.2f%%\n", memory_utilization);
-    printf("Total Page Faults: %d\n", stats.page_faults);
-    printf("Swap Time: %d ms\n", stats.swap_time);
+// Function to take an aligned run of free frames for a huge page. count is a multiple of 64, so
+// the run is whole bitmap words; returns its first frame, or -1 if no aligned run is free.
+int frame_allocator_alloc_run(FrameAllocator* allocator, int count) {
+    int words = count / 64;
+    for (int first = 0; first + words <= allocator->word_count; first += words) {
+        int free_words = 0;
+        while (free_words < words && allocator->words[first + free_words] == ~0ULL) {
+            free_words++;
+        }
+        if (free_words == words) {
+            for (int w = 0; w < words; w++) {
+                allocator->words[first + w] = 0;
+                frame_allocator_update_runs(allocator, first + w);
+            }
+            allocator->free_frames -= count;
+            return first * 64;
+        }
+    }
+    return -1;
 }
-int performance_matrix()
-{
-    int page_count;
-    int pages[MAX_PAGES];
-    int frames[MAX_FRAMES];
-    int use_count[MAX_FRAMES];
-    char fifo_algorithm[10] = "FIFO";
-    char lru_algorithm[10] = "LRU";
-    double fifo_metrics[8], lru_metrics[8]; // Metrics for both algorithms
 
-    // Input frame count
+// Function to pick the size class of a free block: class c holds blocks of 2^c to 2^(c+1)-1 units
+static inline int size_class(int units) {
+    int size_class = 31 - __builtin_clz((unsigned)units);
+    return size_class < CONTIGUOUS_CLASSES ? size_class : CONTIGUOUS_CLASSES - 1;
+}
+
+// Function to add a free block to its list in address order, so fits favour low addresses and
+// leave the large blocks at the top intact
+static void free_block_insert(FreeBlockSet* set, int start, int units) {
+    set->block_size[start] = units;
+    set->block_head[start + units - 1] = start;
+    int list = set->segregated ? size_class(units) : 0;
+    int prev = -1;
+    int next = set->heads[list];
+    while (next >= 0 && next < start) {
+        prev = next;
+        next = set->next[next];
+    }
+    set->prev[start] = prev;
+    set->next[start] = next;
+    if (prev >= 0) {
+        set->next[prev] = start;
+    } else {
+        set->heads[list] = start;
+    }
+    if (next >= 0) {
+        set->prev[next] = start;
+    }
+}
+
+// Function to take a free block off its list
+static void free_block_remove(FreeBlockSet* set, int start) {
+    int list = set->segregated ? size_class(set->block_size[start]) : 0;
+    int prev = set->prev[start];
+    int next = set->next[start];
+    if (prev >= 0) {
+        set->next[prev] = next;
+    } else {
+        set->heads[list] = next;
+    }
+    if (next >= 0) {
+        set->prev[next] = prev;
+    }
+    set->block_size[start] = 0;
+}
 
-    if (total_frames <= 0 || total_frames > MAX_FRAMES) {
-        printf("Invalid frame count. Please enter a value between 1 and %d.\n", MAX_FRAMES);
+// Function to create the boundary-tag free-block set shared by the first-fit, best-fit and
+// segregated-fit allocators, with the whole range as one free block
+static int free_block_set_init(ContiguousState* state, int total_units, int segregated, int best_fit) {
+    FreeBlockSet* set = (FreeBlockSet*)calloc(1, sizeof(FreeBlockSet));
+    state->data = set;
+    if (set == NULL) {
         return 1;
     }
+    set->block_size = (int*)calloc(total_units, sizeof(int));
+    set->block_head = (int*)calloc(total_units, sizeof(int));
+    set->prev = (int*)malloc(total_units * sizeof(int));
+    set->next = (int*)malloc(total_units * sizeof(int));
+    if (set->block_size == NULL || set->block_head == NULL || set->prev == NULL || set->next == NULL) {
+        return 1;
+    }
+    set->segregated = segregated;
+    set->best_fit = best_fit;
+    for (int c = 0; c < CONTIGUOUS_CLASSES; c++) {
+        set->heads[c] = -1;
+    }
+    state->total_units = total_units;
+    state->free_units = total_units;
+    free_block_insert(set, 0, total_units);
+    return 0;
+}
 
-    // Input page count
+static int first_fit_init(ContiguousState* state, int total_units) {
+    return free_block_set_init(state, total_units, 0, 0);
+}
+
+static int best_fit_init(ContiguousState* state, int total_units) {
+    return free_block_set_init(state, total_units, 0, 1);
+}
+
+static int segregated_fit_init(ContiguousState* state, int total_units) {
+    return free_block_set_init(state, total_units, 1, 0);
+}
+
+// Function to allocate from the free-block set: first or best fit over the address-ordered list,
+// or, when segregated, first fit in the request's own class and then any block of a larger class
+static int free_block_alloc(ContiguousState* state, int units) {
+    FreeBlockSet* set = (FreeBlockSet*)state->data;
+    int found = -1;
+    if (!set->segregated) {
+        for (int block = set->heads[0]; block >= 0; block = set->next[block]) {
+            int size = set->block_size[block];
+            if (size >= units && (found < 0 || size < set->block_size[found])) {
+                found = block;
+                if (!set->best_fit || size == units) {
+                    break;
+                }
+            }
+        }
+    } else {
+        int first_class = size_class(units);
+        for (int block = set->heads[first_class]; block >= 0 && found < 0; block = set->next[block]) {
+            if (set->block_size[block] >= units) {
+                found = block;
+            }
+        }
+        for (int c = first_class + 1; c < CONTIGUOUS_CLASSES && found < 0; c++) {
+            found = set->heads[c];
+        }
+    }
+    if (found < 0) {
+        return -1;
+    }
+
+    // Split: the request takes the front, the remainder stays free
+    int size = set->block_size[found];
+    free_block_remove(set, found);
+    if (size > units) {
+        free_block_insert(set, found + units, size - units);
+    }
+    state->free_units -= units;
+    return found;
+}
+
+// Function to free a block, merging it with free neighbours on either side through the boundary tags
+static void free_block_release(ContiguousState* state, int start, int units) {
+    FreeBlockSet* set = (FreeBlockSet*)state->data;
+    state->free_units += units;
+    int end = start + units;
+    if (end < state->total_units && set->block_size[end] > 0) {
+        units += set->block_size[end];
+        free_block_remove(set, end);
+    }
+    if (start > 0) {
+        int left = set->block_head[start - 1];
+        if (left >= 0 && left < start && set->block_size[left] > 0 && left + set->block_size[left] == start) {
+            units += set->block_size[left];
+            free_block_remove(set, left);
+            start = left;
+        }
+    }
+    free_block_insert(set, start, units);
+}
+
+static int free_block_largest(const ContiguousState* state) {
+    const FreeBlockSet* set = (const FreeBlockSet*)state->data;
+    int largest = 0;
+    int lists = set->segregated ? CONTIGUOUS_CLASSES : 1;
+    for (int c = lists - 1; c >= 0 && largest == 0; c--) {
+        // Segregated: every block in the highest non-empty class beats all lower classes
+        for (int block = set->heads[c]; block >= 0; block = set->next[block]) {
+            if (set->block_size[block] > largest) {
+                largest = set->block_size[block];
+            }
+        }
+    }
+    return largest;
+}
+
+static void free_block_destroy(ContiguousState* state) {
+    FreeBlockSet* set = (FreeBlockSet*)state->data;
+    if (set != NULL) {
+        free(set->block_size);
+        free(set->block_head);
+        free(set->prev);
+        free(set->next);
+        free(set);
+    }
+    state->data = NULL;
+}
+
+// Function to give the order of the smallest buddy block holding units
+static inline int buddy_order(int units) {
+    return units <= 1 ? 0 : 32 - __builtin_clz((unsigned)(units - 1));
+}
+
+// Function to push a free buddy block onto the list of its order
+static void buddy_push(BuddyAllocator* buddy, int start, int order) {
+    buddy->order[start] = (int8_t)order;
+    buddy->prev[start] = -1;
+    buddy->next[start] = buddy->heads[order];
+    if (buddy->heads[order] >= 0) {
+        buddy->prev[buddy->heads[order]] = start;
+    }
+    buddy->heads[order] = start;
+}
+
+// Function to unlink a free buddy block from the list of its order
+static void buddy_unlink(BuddyAllocator* buddy, int start) {
+    int order = buddy->order[start];
+    if (buddy->prev[start] >= 0) {
+        buddy->next[buddy->prev[start]] = buddy->next[start];
+    } else {
+        buddy->heads[order] = buddy->next[start];
+    }
+    if (buddy->next[start] >= 0) {
+        buddy->prev[buddy->next[start]] = buddy->prev[start];
+    }
+    buddy->order[start] = -1;
+}
 
-    if (process_count <= 0 || process_count > MAX_PAGES) {
-        printf("Invalid page count. Please enter a value between 1 and %d.\n", MAX_PAGES);
+// Function to create a binary buddy allocator. A range that is not a power of two is covered by the
+// largest aligned blocks that fit, so every unit is usable.
+static int buddy_init(ContiguousState* state, int total_units) {
+    BuddyAllocator* buddy = (BuddyAllocator*)calloc(1, sizeof(BuddyAllocator));
+    state->data = buddy;
+    if (buddy == NULL) {
         return 1;
     }
+    buddy->order = (int8_t*)malloc(total_units);
+    buddy->prev = (int*)malloc(total_units * sizeof(int));
+    buddy->next = (int*)malloc(total_units * sizeof(int));
+    if (buddy->order == NULL || buddy->prev == NULL || buddy->next == NULL) {
+        return 1;
+    }
+    memset(buddy->order, -1, total_units);
+    for (int o = 0; o < BUDDY_MAX_ORDER; o++) {
+        buddy->heads[o] = -1;
+    }
+    state->total_units = total_units;
+    state->free_units = total_units;
+    for (int start = 0; start < total_units;) {
+        int order = start == 0 ? BUDDY_MAX_ORDER - 1 : __builtin_ctz((unsigned)start);
+        while (order > 0 && (order >= BUDDY_MAX_ORDER || start + (1 << order) > total_units)) {
+            order--;
+        }
+        buddy_push(buddy, start, order);
+        start += 1 << order;
+    }
+    return 0;
+}
 
-    // Input page requests
-    // printf("Enter the page requests:\n");
-    for (int i = 0; i < process_count; i++) {
-        // printf("Page request %d = ", i + 1);
-        // scanf("%d", &pages[i]);
-        pages[i]=i + 1;
+// Function to allocate the smallest power-of-two block holding units, splitting larger blocks in O(log n)
+static int buddy_alloc(ContiguousState* state, int units) {
+    BuddyAllocator* buddy = (BuddyAllocator*)state->data;
+    int want = buddy_order(units);
+    int order = want;
+    while (order < BUDDY_MAX_ORDER && buddy->heads[order] < 0) {
+        order++;
+    }
+    if (order >= BUDDY_MAX_ORDER) {
+        return -1;
     }
+    int start = buddy->heads[order];
+    buddy_unlink(buddy, start);
+    while (order > want) {
+        order--;
+        buddy_push(buddy, start + (1 << order), order); // The upper half stays free
+    }
+    state->free_units -= 1 << want;
+    return start;
+}
 
-    for (int algo = 0; algo < 2; algo++) {
-        char *policy = algo == 0 ? fifo_algorithm : lru_algorithm;
+// Function to free a buddy block, merging with its buddy while the buddy is free and of the same order
+static void buddy_release(ContiguousState* state, int start, int units) {
+    BuddyAllocator* buddy = (BuddyAllocator*)state->data;
+    int order = buddy_order(units);
+    state->free_units += 1 << order;
+    while (order + 1 < BUDDY_MAX_ORDER) {
+        int mate = start ^ (1 << order);
+        if (mate + (1 << order) > state->total_units || buddy->order[mate] != order) {
+            break;
+        }
+        buddy_unlink(buddy, mate);
+        start = start < mate ? start : mate;
+        order++;
+    }
+    buddy_push(buddy, start, order);
+}
 
-        // Initialize memory
-        for (int i = 0; i < total_frames; i++) {
-            frames[i] = -1; // Empty frame
-            use_count[i] = 0;
+static int buddy_largest(const ContiguousState* state) {
+    const BuddyAllocator* buddy = (const BuddyAllocator*)state->data;
+    for (int order = BUDDY_MAX_ORDER - 1; order >= 0; order--) {
+        if (buddy->heads[order] >= 0) {
+            return 1 << order;
         }
+    }
+    return 0;
+}
 
-        int page_faults = 0;
-        int current_index = 0;
-        struct timespec start, end;
-        double allocation_time = 0, deallocation_time = 0;
+static void buddy_destroy(ContiguousState* state) {
+    BuddyAllocator* buddy = (BuddyAllocator*)state->data;
+    if (buddy != NULL) {
+        free(buddy->order);
+        free(buddy->prev);
+        free(buddy->next);
+        free(buddy);
+    }
+    state->data = NULL;
+}
 
-        for (int i = 0; i < process_count; i++) {
-            int page = pages[i];
-            clock_gettime(CLOCK_MONOTONIC, &start);
+// Registry of contiguous allocators, compared by the allocation benchmark
+const ContiguousAllocator contiguous_allocators[] = {
+    {"first-fit", first_fit_init, free_block_alloc, free_block_release, free_block_largest, free_block_destroy},
+    {"best-fit", best_fit_init, free_block_alloc, free_block_release, free_block_largest, free_block_destroy},
+    {"buddy", buddy_init, buddy_alloc, buddy_release, buddy_largest, buddy_destroy},
+    {"segregated", segregated_fit_init, free_block_alloc, free_block_release, free_block_largest, free_block_destroy},
+};
+const int contiguous_allocator_count = sizeof(contiguous_allocators) / sizeof(contiguous_allocators[0]);
+
+// Function to draw a request size: mostly small blocks, some medium, a few large ones
+static int churn_request_units(uint64_t* rng) {
+    *rng ^= *rng << 13;
+    *rng ^= *rng >> 7;
+    *rng ^= *rng << 17;
+    int kind = (int)(*rng % 100);
+    uint64_t pick = *rng >> 16;
+    if (kind < 70) {
+        return 1 + (int)(pick % 16);
+    } else if (kind < 95) {
+        return 16 + (int)(pick % 241);
+    }
+    return 256 + (int)(pick % 1793);
+}
 
-            // Check if page is in memory
-            bool in_memory = false;
-            for (int j = 0; j < total_frames; j++) {
-                if (frames[j] == page) {
-                    in_memory = true;
-                    if (strcmp(policy, "LRU") == 0) {
-                        use_count[j] = 1;
+// Function to run a churn workload against one allocator: allocate until the live set reaches the
+// target utilization, then free a random live block for every allocation, sampling fragmentation
+int run_allocation_churn(const ContiguousAllocator* allocator, int total_units, long long operations,
+                         double target_utilization, uint64_t seed, ChurnResult* result) {
+    ContiguousState state = {0, 0, NULL};
+    int capacity = 1024;
+    int* live_start = (int*)malloc(capacity * sizeof(int));
+    int* live_units = (int*)malloc(capacity * sizeof(int));
+    LatencyHistogram* alloc_latency = (LatencyHistogram*)calloc(1, sizeof(LatencyHistogram));
+    if (live_start == NULL || live_units == NULL || alloc_latency == NULL || allocator->init(&state, total_units) != 0) {
+        printf("Error: Could not initialize the %s allocator.\n", allocator->name);
+        allocator->destroy(&state);
+        free(live_start);
+        free(live_units);
+        free(alloc_latency);
+        return 1;
+    }
+    memset(result, 0, sizeof(*result));
+
+    uint64_t rng = seed * 0x9e3779b97f4a7c15ULL + 1;
+    int live_count = 0;
+    long long requested_units = 0; // Units asked for by the live set; the allocator may consume more
+    double fragmentation_sum = 0;
+    long long samples = 0;
+    double free_ns = 0;
+    long long frees = 0;
+    for (long long op = 0; op < operations; op++) {
+        int used_units = state.total_units - state.free_units;
+        int allocate = used_units < target_utilization * state.total_units || live_count == 0;
+        if (allocate) {
+            int units = churn_request_units(&rng);
+            struct timespec before, after;
+            clock_gettime(CLOCK_MONOTONIC, &before);
+            int start = allocator->alloc(&state, units);
+            clock_gettime(CLOCK_MONOTONIC, &after);
+            latency_histogram_record(alloc_latency, (after.tv_sec - before.tv_sec) * 1e9 + (after.tv_nsec - before.tv_nsec));
+            result->allocations++;
+            if (start < 0) {
+                result->failures++;
+                if (state.free_units >= units) {
+                    result->failures_with_space++; // Enough memory, just not in one piece
+                }
+                allocate = 0;
+            } else {
+                if (live_count == capacity) {
+                    capacity *= 2;
+                    int* grown_start = (int*)realloc(live_start, capacity * sizeof(int));
+                    if (grown_start != NULL) {
+                        live_start = grown_start;
+                    }
+                    int* grown_units = (int*)realloc(live_units, capacity * sizeof(int));
+                    if (grown_units != NULL) {
+                        live_units = grown_units;
+                    }
+                    if (grown_start == NULL || grown_units == NULL) {
+                        printf("Error: Memory allocation failed.\n");
+                        break;
                     }
-                    break;
                 }
+                live_start[live_count] = start;
+                live_units[live_count] = units;
+                live_count++;
+                requested_units += units;
             }
+        }
+        if (!allocate && live_count > 0) {
+            rng ^= rng << 13;
+            rng ^= rng >> 7;
+            rng ^= rng << 17;
+            int victim = (int)(rng % live_count);
+            struct timespec before, after;
+            clock_gettime(CLOCK_MONOTONIC, &before);
+            allocator->release(&state, live_start[victim], live_units[victim]);
+            clock_gettime(CLOCK_MONOTONIC, &after);
+            free_ns += (after.tv_sec - before.tv_sec) * 1e9 + (after.tv_nsec - before.tv_nsec);
+            frees++;
+            requested_units -= live_units[victim];
+            live_count--;
+            live_start[victim] = live_start[live_count];
+            live_units[victim] = live_units[live_count];
+        }
 
-            if (!in_memory) {
-                // Page fault occurs
-                page_faults++;
-                int replace_index;
-
-                if (strcmp(policy, "FIFO") == 0) {
-                    replace_index = current_index % total_frames;
-                    current_index++;
-                } else if (strcmp(policy, "LRU") == 0) {
-                    int min_index = 0;
-                    for (int j = 1; j < total_frames; j++) {
-                        if (use_count[j] < use_count[min_index]) {
-                            min_index = j;
-                        }
-                    }
-                    replace_index = min_index;
-                }
+        if (op % CHURN_SAMPLE_INTERVAL == CHURN_SAMPLE_INTERVAL - 1 && state.free_units > 0) {
+            fragmentation_sum += 1.0 - (double)allocator->largest_free(&state) / state.free_units;
+            samples++;
+            int consumed = state.total_units - state.free_units;
+            result->internal_waste += consumed > 0 ? (double)(consumed - requested_units) / consumed : 0;
+        }
+    }
+
+    result->external_fragmentation = samples > 0 ? fragmentation_sum / samples : 0;
+    result->internal_waste = samples > 0 ? result->internal_waste / samples : 0;
+    result->final_largest_free = allocator->largest_free(&state);
+    result->final_free_units = state.free_units;
+    result->mean_alloc_ns = alloc_latency->total > 0 ? alloc_latency->sum_ns / alloc_latency->total : 0;
+    result->p50_alloc_ns = latency_histogram_percentile(alloc_latency, 50.0);
+    result->p99_alloc_ns = latency_histogram_percentile(alloc_latency, 99.0);
+    result->p999_alloc_ns = latency_histogram_percentile(alloc_latency, 99.9);
+    result->mean_free_ns = frees > 0 ? free_ns / frees : 0;
+
+    allocator->destroy(&state);
+    free(live_start);
+    free(live_units);
+    free(alloc_latency);
+    return 0;
+}
+
+// Function to compare the contiguous allocators under the same churn workload
+int run_allocation_benchmark(int argc, char* argv[]) {
+    int total_units = 1 << 18;
+    long long operations = 500000;
+    double target_utilization = 0.85;
+    uint64_t seed = 1;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--units") == 0 && i + 1 < argc) {
+            total_units = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--ops") == 0 && i + 1 < argc) {
+            operations = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--utilization") == 0 && i + 1 < argc) {
+            target_utilization = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            printf("Usage: %s --bench-alloc [--units N] [--ops N] [--utilization F] [--seed N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (total_units <= 0 || operations <= 0 || target_utilization <= 0 || target_utilization > 1) {
+        printf("Invalid benchmark parameters. Units and operations must be greater than 0, utilization in (0, 1].\n");
+        return 1;
+    }
+
+    printf("Churn over %d units, %lld operations, %.0f%% target utilization, seed %llu\n",
+           total_units, operations, target_utilization * 100, (unsigned long long)seed);
+    printf("+------------+------------+------------+------------+------------+---------------+------------+--------------+------------+\n");
+    printf("| Allocator  | Allocs     | Failed     | Failed w/  | Ext Frag   | Largest /     | Int Waste  | Alloc ns     | Free ns    |\n");
+    printf("|            |            |            | Free Space | (avg %%)    | Free (end)    | (avg %%)    | mean / p99   | mean       |\n");
+    printf("+------------+------------+------------+------------+------------+---------------+------------+--------------+------------+\n");
+    for (int a = 0; a < contiguous_allocator_count; a++) {
+        ChurnResult result;
+        if (run_allocation_churn(&contiguous_allocators[a], total_units, operations, target_utilization, seed, &result) != 0) {
+            return 1;
+        }
+        char largest[32], latency[32];
+        snprintf(largest, sizeof(largest), "%d/%d", result.final_largest_free, result.final_free_units);
+        snprintf(latency, sizeof(latency), "%.0f/%.0f", result.mean_alloc_ns, result.p99_alloc_ns);
+        printf("| %-10s | %10lld | %10lld | %10lld | %10.2f | %13s | %10.2f | %12s | %10.0f |\n",
+               contiguous_allocators[a].name, result.allocations, result.failures, result.failures_with_space,
+               result.external_fragmentation * 100, largest, result.internal_waste * 100, latency, result.mean_free_ns);
+    }
+    printf("+------------+------------+------------+------------+------------+---------------+------------+--------------+------------+\n");
+    return 0;
+}
+
+// Function to calculate required pages based on memory requirement and page size
+int required_pages(int memory_requirement, int page_size) {
+    return (int)ceil((double)memory_requirement / page_size);
+}
+
+// Function to find a process by ID; IDs are normally the process's position plus one
+Process* find_process(Process* processes, int process_count, int process_id) {
+    if (process_id >= 1 && process_id <= process_count && processes[process_id - 1].process_id == process_id) {
+        return &processes[process_id - 1];
+    }
+    for (int i = 0; i < process_count; i++) {
+        if (processes[i].process_id == process_id) {
+            return &processes[i];
+        }
+    }
+    return NULL;
+}
 
-                // Simulate memory allocation delay
-                usleep(100); // 100 microseconds
-                frames[replace_index] = page;
-                use_count[replace_index] = 1;
+// Function to set up the slab caches for one page size: 8 bytes up to half a page, in steps of
+// powers of two with a midpoint class (48, 96, 192, ...) from 32 bytes up to bound rounding waste
+int slab_allocator_init(SlabAllocator* allocator, size_t page_bytes) {
+    memset(allocator, 0, sizeof(*allocator));
+    allocator->page_bytes = page_bytes;
+    allocator->free_slab = -1;
+    for (size_t size = 8; size <= page_bytes / 2 && allocator->cache_count < SLAB_MAX_CLASSES; size *= 2) {
+        int sizes[2] = {(int)size, size >= 32 ? (int)(size + size / 2) : 0};
+        for (int s = 0; s < 2 && allocator->cache_count < SLAB_MAX_CLASSES; s++) {
+            if (sizes[s] == 0 || (size_t)sizes[s] > page_bytes / 2) {
+                continue;
             }
+            SlabCache* cache = &allocator->caches[allocator->cache_count++];
+            cache->object_size = sizes[s];
+            cache->objects_per_slab = (int)(page_bytes / sizes[s]);
+            for (int l = 0; l < SLAB_LISTS; l++) {
+                cache->lists[l] = -1;
+            }
+        }
+    }
+    return 0;
+}
 
-            // Increment use counts for LRU
-            if (strcmp(policy, "LRU") == 0) {
-                for (int j = 0; j < total_frames; j++) {
-                    if (frames[j] != page) {
-                        use_count[j]++;
-                    }
-                }
+// Function to pick the smallest size class holding size bytes, or -1 if it needs whole pages
+int slab_size_class(const SlabAllocator* allocator, int size) {
+    for (int c = 0; c < allocator->cache_count; c++) {
+        if (allocator->caches[c].object_size >= size) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+// Function to move a slab onto the partial, full or empty list of its cache
+static void slab_list_move(SlabAllocator* allocator, int index, int list) {
+    Slab* slab = &allocator->slabs[index];
+    SlabCache* cache = &allocator->caches[slab->cache];
+    if (slab->list >= 0) {
+        if (slab->prev >= 0) {
+            allocator->slabs[slab->prev].next = slab->next;
+        } else {
+            cache->lists[slab->list] = slab->next;
+        }
+        if (slab->next >= 0) {
+            allocator->slabs[slab->next].prev = slab->prev;
+        }
+        cache->slab_count[slab->list]--;
+    }
+    slab->list = list;
+    if (list >= 0) {
+        slab->prev = -1;
+        slab->next = cache->lists[list];
+        if (slab->next >= 0) {
+            allocator->slabs[slab->next].prev = index;
+        }
+        cache->lists[list] = index;
+        cache->slab_count[list]++;
+    }
+}
+
+// Function to build a new slab for a cache on a free frame; returns the slab, or -1 with no frame free
+static int slab_create(SlabAllocator* allocator, Frame* frames, int cache_index) {
+    int frame;
+    if (frame_allocator_alloc(&frame_allocator, 1, &frame) < 1) {
+        return -1;
+    }
+    int index = allocator->free_slab;
+    if (index >= 0) {
+        allocator->free_slab = allocator->slabs[index].next;
+    } else {
+        if (allocator->slab_count == allocator->slab_capacity) {
+            int capacity = allocator->slab_capacity > 0 ? allocator->slab_capacity * 2 : 16;
+            Slab* slabs = (Slab*)realloc(allocator->slabs, capacity * sizeof(Slab));
+            if (slabs == NULL) {
+                frame_allocator_free(&frame_allocator, frame);
+                printf("Error: Memory allocation failed.\n");
+                return -1;
             }
+            allocator->slabs = slabs;
+            allocator->slab_capacity = capacity;
+        }
+        index = allocator->slab_count++;
+    }
 
-            clock_gettime(CLOCK_MONOTONIC, &end);
-            allocation_time += ((end.tv_sec - start.tv_sec) * 1000000L) +
-                   (end.tv_nsec - start.tv_nsec);
+    const SlabCache* cache = &allocator->caches[cache_index];
+    Slab* slab = &allocator->slabs[index];
+    int words = (cache->objects_per_slab + 63) / 64;
+    slab->free_map = (uint64_t*)malloc(words * sizeof(uint64_t));
+    if (slab->free_map == NULL) {
+        frame_allocator_free(&frame_allocator, frame);
+        slab->frame = -1;
+        slab->next = allocator->free_slab;
+        allocator->free_slab = index;
+        printf("Error: Memory allocation failed.\n");
+        return -1;
+    }
+    for (int w = 0; w < words; w++) {
+        slab->free_map[w] = ~0ULL;
+    }
+    if (cache->objects_per_slab % 64 != 0) {
+        slab->free_map[words - 1] = (1ULL << (cache->objects_per_slab % 64)) - 1;
+    }
+    slab->frame = frame;
+    slab->cache = cache_index;
+    slab->in_use = 0;
+    slab->list = -1;
+    slab_list_move(allocator, index, SLAB_EMPTY);
 
+    // Slab frames belong to no process; they are pinned, so the swap path never picks them
+    frames[frame].assigned = 1;
+    frames[frame].prefetched = 0;
+    frames[frame].process_id = SLAB_OWNER;
+    frames[frame].page_number = index + 1;
+    allocator->slabs_created++;
+    return index;
+}
+
+// Function to give a slab's frame back to the frame allocator once it is empty
+static void slab_destroy(SlabAllocator* allocator, Frame* frames, int index) {
+    Slab* slab = &allocator->slabs[index];
+    slab_list_move(allocator, index, -1);
+    frame_allocator_free(&frame_allocator, slab->frame);
+    frames[slab->frame].assigned = 0;
+    frames[slab->frame].process_id = -1;
+    frames[slab->frame].page_number = -1;
+    free(slab->free_map);
+    slab->free_map = NULL;
+    slab->frame = -1;
+    slab->next = allocator->free_slab;
+    allocator->free_slab = index;
+    allocator->slabs_released++;
+}
+
+// Function to allocate one object of size bytes: partial slabs first, then an empty one, then a
+// new slab on a free frame. Returns 0, or 1 if no frame could be found.
+int slab_alloc(SlabAllocator* allocator, Frame* frames, int size, SlabObject* object) {
+    int cache_index = slab_size_class(allocator, size);
+    if (cache_index < 0) {
+        return 1;
+    }
+    SlabCache* cache = &allocator->caches[cache_index];
+    int index = cache->lists[SLAB_PARTIAL] >= 0 ? cache->lists[SLAB_PARTIAL] : cache->lists[SLAB_EMPTY];
+    if (index < 0) {
+        index = slab_create(allocator, frames, cache_index);
+        if (index < 0) {
+            return 1;
         }
+    }
+    Slab* slab = &allocator->slabs[index];
+    int word = 0;
+    while (slab->free_map[word] == 0) {
+        word++;
+    }
+    int slot = word * 64 + __builtin_ctzll(slab->free_map[word]);
+    slab->free_map[word] &= slab->free_map[word] - 1;
+    slab->in_use++;
+    slab_list_move(allocator, index, slab->in_use == cache->objects_per_slab ? SLAB_FULL : SLAB_PARTIAL);
 
-        // Simulate deallocation delay
-        deallocation_time = allocation_time * 0.2;
+    cache->objects_in_use++;
+    cache->bytes_requested += size;
+    allocator->allocations++;
+    object->slab = index;
+    object->slot = slot;
+    object->size = size;
+    return 0;
+}
 
-        // Store performance metrics
-        double memory_utilization = ((double)total_frames / MAX_FRAMES) * 100.0;
-        double fragmentation = ((rand() % 10) + 1) / 10.0;
-        double throughput = process_count / (allocation_time / 1000.0);
-        double response_time = allocation_time / process_count;
-        double thrashing_rate = (double)page_faults / process_count;
-        double overhead = allocation_time * 0.1;
+// Function to free one object. An emptied slab stays cached for reuse unless its cache already
+// holds SLAB_EMPTY_KEEP empty slabs, in which case its frame goes back to the frame allocator.
+void slab_free(SlabAllocator* allocator, Frame* frames, const SlabObject* object) {
+    Slab* slab = &allocator->slabs[object->slab];
+    SlabCache* cache = &allocator->caches[slab->cache];
+    slab->free_map[object->slot / 64] |= 1ULL << (object->slot % 64);
+    slab->in_use--;
+    cache->objects_in_use--;
+    cache->bytes_requested -= object->size;
+    allocator->frees++;
+    if (slab->in_use > 0) {
+        slab_list_move(allocator, object->slab, SLAB_PARTIAL);
+    } else if (cache->slab_count[SLAB_EMPTY] < SLAB_EMPTY_KEEP) {
+        slab_list_move(allocator, object->slab, SLAB_EMPTY);
+    } else {
+        slab_destroy(allocator, frames, object->slab);
+    }
+}
 
-        double *metrics = algo == 0 ? fifo_metrics : lru_metrics;
-        metrics[0] = memory_utilization;
-        metrics[1] = fragmentation;
-        metrics[2] = allocation_time;
-        metrics[3] = deallocation_time;
-        metrics[4] = throughput;
-        metrics[5] = response_time;
-        metrics[6] = thrashing_rate;
-        metrics[7] = overhead;
+// Function to add an object to a process's list of live objects
+static int process_add_object(Process* process, const SlabObject* object, int object_size) {
+    if (process->object_count == process->object_capacity) {
+        int capacity = process->object_capacity > 0 ? process->object_capacity * 2 : 64;
+        SlabObject* objects = (SlabObject*)realloc(process->objects, capacity * sizeof(SlabObject));
+        if (objects == NULL) {
+            printf("Error: Memory allocation failed.\n");
+            return 1;
+        }
+        process->objects = objects;
+        process->object_capacity = capacity;
     }
+    process->objects[process->object_count++] = *object;
+    process->object_bytes_requested += object->size;
+    process->object_bytes_consumed += object_size;
+    return 0;
+}
 
-    // Display performance matrix
-    printf("+-----------------------------+---------------+---------------+\n");
-    printf("| Entity                      | FIFO          | LRU           |\n");
-    printf("+-----------------------------+---------------+---------------+\n");
-    //printf("| Fragmentation(%%)            | %13.2f | %13.2f |\n", fifo_metrics[1]*100, lru_metrics[1]*100);
-    printf("| Allocation Time (micros)    | %13.2f | %13.2f |\n", fifo_metrics[2], lru_metrics[2]);
-    printf("| Deallocation Time (micros)  | %13.2f | %13.2f |\n", fifo_metrics[3], lru_metrics[3]);
-    printf("| Throughput (pages/s)        | %13.2f | %13.2f |\n", fifo_metrics[4], lru_metrics[4]);
-    printf("| Response Time (micros)      | %13.2f | %13.2f |\n", fifo_metrics[5], lru_metrics[5]);
-    printf("| Thrashing Rate              | %13.2f | %13.2f |\n", fifo_metrics[6], lru_metrics[6]);
-    printf("| Overhead (micros)           | %13.2f | %13.2f |\n", fifo_metrics[7], lru_metrics[7]);
-    printf("+-----------------------------+---------------+---------------+\n");
+// Function to free the object at one position of a process's list; the last object takes its place
+static void process_free_object(Process* process, Frame* frames, int position) {
+    SlabObject* object = &process->objects[position];
+    process->object_bytes_requested -= object->size;
+    process->object_bytes_consumed -= slab_allocator.caches[slab_allocator.slabs[object->slab].cache].object_size;
+    slab_free(&slab_allocator, frames, object);
+    process->objects[position] = process->objects[--process->object_count];
+}
+
+// Function to free every object a process holds
+void free_process_objects(Process* process, Frame* frames) {
+    while (process->object_count > 0) {
+        process_free_object(process, frames, process->object_count - 1);
+    }
+    free(process->objects);
+    process->objects = NULL;
+    process->object_capacity = 0;
+}
+
+// Function to allocate many small objects for a process from the slab caches
+void allocate_small_objects(Process* processes, int process_count, Frame* frames) {
+    int process_id, size, count;
+    printf("Enter process ID: ");
+    scanf("%d", &process_id);
+    printf("Enter object size (in bytes): ");
+    scanf("%d", &size);
+    printf("Enter number of objects: ");
+    scanf("%d", &count);
+
+    Process* process = find_process(processes, process_count, process_id);
+    if (process == NULL) {
+        printf("Process %d not found\n", process_id);
+        return;
+    }
+    int cache_index = size > 0 ? slab_size_class(&slab_allocator, size) : -1;
+    if (cache_index < 0 || count <= 0) {
+        printf("Invalid object size or count. Objects must be 1 to %d bytes; larger ones take whole pages.\n",
+               slab_allocator.caches[slab_allocator.cache_count - 1].object_size);
+        return;
+    }
+    int object_size = slab_allocator.caches[cache_index].object_size;
+    int allocated = 0;
+    int previous_phase = probe_enter(PROBE_ALLOCATION);
+    while (allocated < count) {
+        SlabObject object;
+        if (slab_alloc(&slab_allocator, frames, size, &object) != 0) {
+            break;
+        }
+        if (process_add_object(process, &object, object_size) != 0) {
+            slab_free(&slab_allocator, frames, &object);
+            break;
+        }
+        allocated++;
+    }
+    probe_leave(previous_phase);
+    printf("Process %d allocated %d of %d objects of %d bytes from the %d-byte slab cache\n",
+           process_id, allocated, count, size, object_size);
+    if (allocated < count) {
+        printf("No free frame for a new slab; %d objects were not allocated\n", count - allocated);
+    }
+}
+
+// Function to free some of a process's small objects, spread evenly over the ones it holds so
+// that slabs are left partly used, as they are by real frees
+void free_small_objects(Process* processes, int process_count, Frame* frames) {
+    int process_id, count;
+    printf("Enter process ID: ");
+    scanf("%d", &process_id);
+    printf("Enter number of objects to free: ");
+    scanf("%d", &count);
+
+    Process* process = find_process(processes, process_count, process_id);
+    if (process == NULL || process->object_count == 0) {
+        printf("Process %d holds no small objects\n", process_id);
+        return;
+    }
+    if (count > process->object_count) {
+        count = process->object_count;
+    }
+    int stride = count > 0 ? process->object_count / count : 1;
+    int freed = 0;
+    // Walking down keeps the positions still to visit valid as the last object fills each hole
+    for (int i = process->object_count - 1; i >= 0 && freed < count; i--) {
+        if (i % stride == 0) {
+            process_free_object(process, frames, i);
+            freed++;
+        }
+    }
+    printf("Process %d freed %d small objects, %d left\n", process_id, freed, process->object_count);
+}
 
+// Function to print the slab caches in use: slabs per list, objects and the bytes they waste
+void slab_report(const SlabAllocator* allocator) {
+    printf("Slab caches (%lld allocations, %lld frees, %lld slabs created, %lld released):\n",
+           allocator->allocations, allocator->frees, allocator->slabs_created, allocator->slabs_released);
+    printf("  %8s %8s %8s %8s %10s %14s %14s\n", "Size", "Partial", "Full", "Empty", "Objects", "Requested (B)", "Slab bytes");
+    for (int c = 0; c < allocator->cache_count; c++) {
+        const SlabCache* cache = &allocator->caches[c];
+        int slabs = cache->slab_count[SLAB_PARTIAL] + cache->slab_count[SLAB_FULL] + cache->slab_count[SLAB_EMPTY];
+        if (slabs == 0) {
+            continue;
+        }
+        printf("  %8d %8d %8d %8d %10lld %14lld %14zu\n", cache->object_size, cache->slab_count[SLAB_PARTIAL],
+               cache->slab_count[SLAB_FULL], cache->slab_count[SLAB_EMPTY], cache->objects_in_use,
+               cache->bytes_requested, slabs * allocator->page_bytes);
+    }
+}
+
+// Function to release the slab bookkeeping; the frames go with the frame allocator
+void slab_allocator_free(SlabAllocator* allocator) {
+    for (int s = 0; s < allocator->slab_count; s++) {
+        free(allocator->slabs[s].free_map);
+    }
+    free(allocator->slabs);
+    allocator->slabs = NULL;
+    allocator->slab_count = 0;
+}
+
+// Function to give a newly mapped page its initial contents when pages carry real data. Page N of
+// every process starts as page N of one common image, as tenants running the same program would;
+// the page becomes the process's own once it writes to it.
+static void fill_new_page(int frame, int page_number) {
+    if (frame_data != NULL) {
+        swap_page_fill(frame_data + (size_t)frame * page_image_bytes, page_image_bytes, make_page_key(0, page_number));
+    }
+}
+
+// Function to note that a frame is giving up its page; a page brought in by readahead and never
+// referenced counts as wasted and halves the process's readahead window
+static void readahead_release(Frame* frame, Process* process) {
+    if (frame->prefetched) {
+        frame->prefetched = 0;
+        stats.prefetch_wasted++;
+        if (process->readahead_window / 2 >= READAHEAD_MIN_PAGES) {
+            process->readahead_window /= 2;
+        }
+    }
+}
+
+// Function to set up one set-associative translation array; entries must divide into the ways
+static int tlb_array_init(TlbArray* array, int entries, int ways) {
+    if (entries <= 0 || ways <= 0 || entries % ways != 0) {
+        printf("Error: A TLB of %d entries cannot be %d-way set associative.\n", entries, ways);
+        return 1;
+    }
+    array->sets = entries / ways;
+    array->ways = ways;
+    array->clock = 0;
+    array->tags = (page_key*)malloc(entries * sizeof(page_key));
+    array->values = (int*)malloc(entries * sizeof(int));
+    array->stamps = (uint64_t*)calloc(entries, sizeof(uint64_t));
+    if (array->tags == NULL || array->values == NULL || array->stamps == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        return 1;
+    }
+    for (int i = 0; i < entries; i++) {
+        array->tags[i] = PAGE_KEY_NONE;
+    }
+    return 0;
+}
+
+// Function to find the first entry of the set a key maps to; sets are picked by the low page bits
+static inline int tlb_array_set(const TlbArray* array, page_key key) {
+    return (int)((uint32_t)key % (uint32_t)array->sets) * array->ways;
+}
+
+// Function to look a key up; on a hit the entry becomes the newest in its set
+static int tlb_array_lookup(TlbArray* array, page_key key, int* value) {
+    int first = tlb_array_set(array, key);
+    for (int way = first; way < first + array->ways; way++) {
+        if (array->tags[way] == key) {
+            array->stamps[way] = ++array->clock;
+            *value = array->values[way];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Function to fill an entry, replacing an empty way or else the least recently used one
+static void tlb_array_insert(TlbArray* array, page_key key, int value) {
+    int first = tlb_array_set(array, key);
+    int victim = first;
+    for (int way = first; way < first + array->ways; way++) {
+        if (array->tags[way] == key || array->tags[way] == PAGE_KEY_NONE) {
+            victim = way;
+            break;
+        }
+        if (array->stamps[way] < array->stamps[victim]) {
+            victim = way;
+        }
+    }
+    array->tags[victim] = key;
+    array->values[victim] = value;
+    array->stamps[victim] = ++array->clock;
+}
+
+static void tlb_array_invalidate(TlbArray* array, page_key key) {
+    int first = tlb_array_set(array, key);
+    for (int way = first; way < first + array->ways; way++) {
+        if (array->tags[way] == key) {
+            array->tags[way] = PAGE_KEY_NONE;
+        }
+    }
+}
+
+static void tlb_array_free(TlbArray* array) {
+    free(array->tags);
+    free(array->values);
+    free(array->stamps);
+}
+
+// Function to set up the TLBs (base-page and huge-page arrays of the same associativity) and a
+// fully associative page-walk cache for each upper page-table level
+int mmu_init(Mmu* unit, int entries, int ways, int huge_entries) {
+    memset(unit, 0, sizeof(*unit));
+    if (tlb_array_init(&unit->base, entries, ways) != 0 || tlb_array_init(&unit->huge, huge_entries, ways) != 0) {
+        return 1;
+    }
+    for (int level = 0; level < PAGE_TABLE_LEVELS - 1; level++) {
+        if (tlb_array_init(&unit->walk_cache[level], WALK_CACHE_ENTRIES, WALK_CACHE_ENTRIES) != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void mmu_free(Mmu* unit) {
+    tlb_array_free(&unit->base);
+    tlb_array_free(&unit->huge);
+    for (int level = 0; level < PAGE_TABLE_LEVELS - 1; level++) {
+        tlb_array_free(&unit->walk_cache[level]);
+    }
+}
+
+// Function to translate one page of a process as the hardware would: both TLB arrays first, then
+// a radix walk from the root down to the leaf. The walk starts below the deepest upper-level
+// entry the page-walk caches hold, and each level it reads costs a DRAM access. A process's pages
+// run from virtual page 1 up, so every upper-level entry above a mapped page exists; the leaf
+// level is the process's page table. Returns 1 if the page is resident, 0 if the walk faults.
+int mmu_translate(Process* process, Frame* frames, int index) {
+    uint32_t process_id = (uint32_t)process->process_id;
+    int frame;
+    stats.tlb_lookups++;
+    if (tlb_array_lookup(&mmu.base, make_page_key(process_id, (uint32_t)index), &frame)) {
+        stats.tlb_hits++;
+        return 1;
+    }
+    if (tlb_array_lookup(&mmu.huge, make_page_key(process_id, (uint32_t)(index >> PAGE_TABLE_BITS)), &frame)) {
+        stats.tlb_hits++;
+        stats.huge_tlb_hits++;
+        return 1;
+    }
+
+    // A huge page is a leaf one level up, in the page directory
+    int entry = process->page_table[index];
+    int huge = entry >= 0 && frames[entry].huge;
+    int leaf_level = huge ? PAGE_TABLE_LEVELS - 2 : PAGE_TABLE_LEVELS - 1;
+    int start = 0;
+    for (int level = leaf_level - 1; level >= 0; level--) {
+        uint32_t prefix = (uint32_t)index >> (PAGE_TABLE_BITS * (PAGE_TABLE_LEVELS - 1 - level));
+        if (tlb_array_lookup(&mmu.walk_cache[level], make_page_key(process_id, prefix), &frame)) {
+            start = level + 1;
+            stats.walk_cache_hits++;
+            break;
+        }
+    }
+    for (int level = start; level < leaf_level; level++) {
+        uint32_t prefix = (uint32_t)index >> (PAGE_TABLE_BITS * (PAGE_TABLE_LEVELS - 1 - level));
+        tlb_array_insert(&mmu.walk_cache[level], make_page_key(process_id, prefix), 0);
+    }
+    int levels = leaf_level - start + 1;
+    stats.page_walks++;
+    stats.walk_levels += levels;
+    stats.translation_ns += levels * timing_model.dram_hit_ns;
+
+    if (entry < 0) {
+        return 0;
+    }
+    if (huge) {
+        tlb_array_insert(&mmu.huge, make_page_key(process_id, (uint32_t)(index >> PAGE_TABLE_BITS)),
+                         entry - (index & (HUGE_PAGE_PAGES - 1)));
+    } else {
+        tlb_array_insert(&mmu.base, make_page_key(process_id, (uint32_t)index), entry);
+    }
+    return 1;
+}
+
+// Function to split the huge page holding a page back into base pages, as when one of its pages
+// is about to be swapped out or released; the frames stay where they are
+static void split_huge_page(Process* process, Frame* frames, int index) {
+    int first = index & ~(HUGE_PAGE_PAGES - 1);
+    int entry = process->page_table[index];
+    if (entry < 0 || !frames[entry].huge) {
+        return;
+    }
+    for (int k = 0; k < HUGE_PAGE_PAGES; k++) {
+        frames[process->page_table[first + k]].huge = 0;
+    }
+    tlb_array_invalidate(&mmu.huge, make_page_key((uint32_t)process->process_id, (uint32_t)(first >> PAGE_TABLE_BITS)));
+    process->huge_regions--;
+    stats.huge_pages--;
+}
+
+// Function to drop the translations of a page before its mapping changes
+void mmu_invalidate(Process* process, Frame* frames, int index) {
+    split_huge_page(process, frames, index);
+    tlb_array_invalidate(&mmu.base, make_page_key((uint32_t)process->process_id, (uint32_t)index));
+}
+
+// Function to drop every translation and walk-cache entry of a process
+void mmu_flush_process(Mmu* unit, int process_id) {
+    TlbArray* arrays[2 + PAGE_TABLE_LEVELS - 1] = {&unit->base, &unit->huge};
+    for (int level = 0; level < PAGE_TABLE_LEVELS - 1; level++) {
+        arrays[2 + level] = &unit->walk_cache[level];
+    }
+    for (int a = 0; a < 2 + PAGE_TABLE_LEVELS - 1; a++) {
+        for (int i = 0; i < arrays[a]->sets * arrays[a]->ways; i++) {
+            if (arrays[a]->tags[i] != PAGE_KEY_NONE && (arrays[a]->tags[i] >> 32) == (uint32_t)process_id) {
+                arrays[a]->tags[i] = PAGE_KEY_NONE;
+            }
+        }
+    }
+}
+
+// Function to map a process's memory with huge pages where it can. Every whole region of
+// HUGE_PAGE_PAGES pages that is fully resident moves onto an aligned run of free frames, the
+// way khugepaged collapses base pages; regions with pages on disk or shared are left alone.
+void map_huge_pages(Process* processes, int process_count, Frame* frames) {
+    int process_id;
+    printf("Enter process ID to map with huge pages: ");
+    scanf("%d", &process_id);
+    Process* process = find_process(processes, process_count, process_id);
+    if (process == NULL) {
+        printf("Process %d not found\n", process_id);
+        return;
+    }
+    if (frame_allocator.total_frames < HUGE_PAGE_PAGES) {
+        printf("A huge page needs %d contiguous frames; there are only %d\n", HUGE_PAGE_PAGES, frame_allocator.total_frames);
+        return;
+    }
+    int previous_phase = probe_enter(PROBE_ALLOCATION);
+    int collapsed = 0, already = 0, not_resident = 0, no_run = 0;
+    for (int first = 0; first + HUGE_PAGE_PAGES <= process->page_table_size; first += HUGE_PAGE_PAGES) {
+        if (process->page_table[first] >= 0 && frames[process->page_table[first]].huge) {
+            already++;
+            continue;
+        }
+        int resident = 1;
+        for (int k = 0; k < HUGE_PAGE_PAGES && resident; k++) {
+            int entry = process->page_table[first + k];
+            resident = entry >= 0 && frames[entry].process_id == process_id; // Shared frames stay where they are
+        }
+        if (!resident) {
+            not_resident++;
+            continue;
+        }
+        int base = frame_allocator_alloc_run(&frame_allocator, HUGE_PAGE_PAGES);
+        if (base < 0) {
+            no_run++;
+            continue;
+        }
+        for (int k = 0; k < HUGE_PAGE_PAGES; k++) {
+            int old = process->page_table[first + k];
+            if (frame_data != NULL) {
+                memcpy(frame_data + (size_t)(base + k) * page_image_bytes, frame_data + (size_t)old * page_image_bytes, page_image_bytes);
+            }
+            frames[base + k] = frames[old];
+            frames[base + k].huge = 1;
+            frames[old].assigned = 0;
+            frames[old].prefetched = 0;
+            frames[old].process_id = -1;
+            frames[old].page_number = -1;
+            frame_allocator_free(&frame_allocator, old);
+            tlb_array_invalidate(&mmu.base, make_page_key((uint32_t)process_id, (uint32_t)(first + k)));
+            process->page_table[first + k] = base + k;
+        }
+        // The page-directory entry now is the leaf, so a cached pointer to the old page table goes
+        tlb_array_invalidate(&mmu.walk_cache[PAGE_TABLE_LEVELS - 2],
+                             make_page_key((uint32_t)process_id, (uint32_t)(first >> PAGE_TABLE_BITS)));
+        process->huge_regions++;
+        stats.huge_pages++;
+        collapsed++;
+    }
+    probe_leave(previous_phase);
+    printf("Process %d: %d huge pages mapped, %d already huge, %d regions with pages on disk or shared, %d without an aligned free run\n",
+           process_id, collapsed, already, not_resident, no_run);
+}
+
+// Function to drop a shared frame from the scanner's stable index once it stops being shared
+static void page_scanner_forget(PageScanner* scanner, int frame) {
+    if (scanner->checksums != NULL && page_index_find(&scanner->stable, scanner->checksums[frame]) == frame) {
+        page_index_remove(&scanner->stable, scanner->checksums[frame]);
+    }
+}
+
+// Function to drop one mapping of a frame; a shared frame is freed only with its last mapping
+static void release_frame(Frame* frames, int frame) {
+    if (frames[frame].process_id == SHARED_OWNER) {
+        stats.shared_mappings--;
+        if (--frames[frame].page_number > 0) {
+            return;
+        }
+        stats.shared_frames--;
+        page_scanner_forget(&page_scanner, frame);
+    }
+    frame_allocator_free(&frame_allocator, frame);
+    frames[frame].assigned = 0;
+    frames[frame].process_id = -1;
+    frames[frame].page_number = -1;
+}
+
+// Function to release the frame or swap slot behind one page table entry
+static void unmap_page(Frame* frames, Process* process, int index) {
+    mmu_invalidate(process, frames, index);
+    int entry = process->page_table[index];
+    if (entry >= 0) {
+        readahead_release(&frames[entry], process);
+        release_frame(frames, entry);
+        process->resident_pages--;
+    } else if (PAGE_ON_DISK(entry)) {
+        if (compressed_pool.capacity_bytes > 0) {
+            compressed_pool_drop(&compressed_pool, ENTRY_SWAP_SLOT(entry));
+        }
+        disk_pool_free_slot(&disk, ENTRY_SWAP_SLOT(entry));
+        disk_page_count--;
+    }
+    process->mapped_pages -= entry != PAGE_UNMAPPED;
+    process->page_table[index] = PAGE_UNMAPPED;
+}
+
+// Function to grow or shrink a page table; pages cut off by shrinking are released
+int resize_page_table(Frame* frames, Process* process, int pages) {
+    for (int i = pages; i < process->page_table_size; i++) {
+        unmap_page(frames, process, i);
+    }
+    if (pages > process->page_table_size) {
+        int* table = (int*)realloc(process->page_table, pages * sizeof(int));
+        if (table != NULL) {
+            process->page_table = table;
+        }
+        long long* last_use = (long long*)realloc(process->last_use, pages * sizeof(long long));
+        if (last_use != NULL) {
+            process->last_use = last_use;
+        }
+        if (table == NULL || last_use == NULL) {
+            printf("Error: Memory allocation failed.\n");
+            return 1;
+        }
+        for (int i = process->page_table_size; i < pages; i++) {
+            table[i] = PAGE_UNMAPPED;
+            last_use[i] = 0;
+        }
+    }
+    process->page_table_size = pages;
+    return 0;
+}
+
+// Function to count the frames a process could get: free frames plus, under load control, private
+// pages of other processes that have dropped out of their working sets
+static int admission_room(Process* processes, int process_count, const Frame* frames, const Process* requester) {
+    int room = frame_allocator.free_frames;
+    for (int i = 0; i < process_count && load_control.enabled; i++) {
+        const Process* other = &processes[i];
+        for (int j = 0; other != requester && j < other->page_table_size; j++) {
+            int entry = other->page_table[j];
+            room += entry >= 0 && frames[entry].process_id != SHARED_OWNER && other->virtual_time - other->last_use[j] >= load_control.window;
+        }
+    }
+    return room;
+}
+
+// Function to map every unmapped page of one process. Free frames go first; then, as in WSClock,
+// pages of other processes are reclaimed: only those outside their working sets under load
+// control, the least recently used otherwise. Under load control a process whose pages cannot
+// all fit is not admitted; it waits until enough frames are free.
+int allocate_process_memory(Process* processes, int process_count, Process* process, Frame* frames, int page_size) {
+    int pages_needed = required_pages(process->memory_requirement, page_size);
+    if (resize_page_table(frames, process, pages_needed) != 0) {
+        return 1;
+    }
+
+    // Only pages without a frame or swap slot need new frames
+    int unmapped_pages = 0;
+    for (int j = 0; j < pages_needed; j++) {
+        if (process->page_table[j] == PAGE_UNMAPPED) {
+            unmapped_pages++;
+        }
+    }
+    if (load_control.enabled && !process->allocated && unmapped_pages > 0) {
+        int room = admission_room(processes, process_count, frames, process); // Scans every process; taken once
+        if (room < unmapped_pages) {
+            if (!process->deferred) {
+                process->deferred = 1;
+                process->queued_at = load_control.checks;
+                load_control.deferrals++;
+            }
+            process->state = WAITING;
+            printf("Process %d waits for admission: %d pages needed, %d frames free or outside working sets\n",
+                   process->process_id, unmapped_pages, room);
+            return 0;
+        }
+    }
+    int* free_list = (int*)malloc((unmapped_pages > 0 ? unmapped_pages : 1) * sizeof(int));
+    if (free_list == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        return 1;
+    }
+
+    // Take as many free frames as the process needs from the free-frame bitmap in one call
+    int allocated = frame_allocator_alloc(&frame_allocator, unmapped_pages, free_list);
+    int next = 0;
+    for (int j = 0; j < pages_needed && next < allocated; j++) {
+        if (process->page_table[j] == PAGE_UNMAPPED) {
+            int frame = free_list[next++];
+            frames[frame].assigned = 1;
+            frames[frame].process_id = process->process_id;
+            frames[frame].page_number = j + 1;
+            fill_new_page(frame, j + 1);
+            process->page_table[j] = frame;
+            process->last_use[j] = process->virtual_time;
+            process->resident_pages++;
+            process->mapped_pages++;
+        }
+    }
+    free(free_list);
+
+    // If not enough frames are free, reclaim pages of other processes
+    int mapped_pages = pages_needed - unmapped_pages + allocated;
+    for (int j = 0; j < pages_needed && mapped_pages < pages_needed; j++) {
+        if (process->page_table[j] != PAGE_UNMAPPED) {
+            continue;
+        }
+        int frame = reclaim_frame(processes, process_count, frames, process, load_control.enabled);
+        if (frame < 0 || frame_allocator_alloc(&frame_allocator, 1, &frame) != 1) {
+            break;
+        }
+        frames[frame].assigned = 1;
+        frames[frame].process_id = process->process_id;
+        frames[frame].page_number = j + 1;
+        fill_new_page(frame, j + 1);
+        process->page_table[j] = frame;
+        process->last_use[j] = process->virtual_time;
+        process->resident_pages++;
+        process->mapped_pages++;
+        mapped_pages++;
+    }
+
+    // Set process allocation status
+    if (mapped_pages == pages_needed) {
+        if (process->deferred) {
+            process->deferred = 0;
+            process->admitted_at = load_control.checks;
+            load_control.admissions++;
+        }
+        process->allocated = 1;
+        process->state = RUNNING; // Set state to RUNNING
+        printf("Process %d allocated %d pages\n", process->process_id, pages_needed);
+    } else {
+        printf("Process %d could not be allocated due to insufficient memory\n", process->process_id);
+    }
+    return 0;
+}
+
+// Function to allocate memory for processes
+void allocate_memory(Process* processes, int process_count, Frame* frames, int total_frames, int page_size) {
+    int previous_phase = probe_enter(PROBE_ALLOCATION);
+    for (int i = 0; i < process_count; i++) {
+        if (allocate_process_memory(processes, process_count, &processes[i], frames, page_size) != 0) {
+            break;
+        }
+    }
+    probe_leave(previous_phase);
+}
+
+// Function to write a page image to its swap slot: the compressed tier first, the swap file for
+// pages it rejects or fails to store. Returns 1 if the tier kept the page.
+static int store_page_image(int slot, const unsigned char* data, const Process* process, int page_number) {
+    int in_tier = compressed_pool.capacity_bytes > 0 ? compressed_pool_store(&compressed_pool, slot, data) : 0;
+    if (in_tier < 0) {
+        printf("Error: Page %d of process %d could not be stored in the compressed tier\n", page_number, process->process_id);
+        in_tier = 0;
+    }
+    if (in_tier == 0 && swap_file.fd >= 0 && swap_file_write(&swap_file, slot, data) != 0) {
+        printf("Error: Page %d of process %d could not be written to the swap file\n", page_number, process->process_id);
+    }
+    return in_tier;
+}
+
+// Function to swap out a page from RAM to disk; returns the swap slot, or -1 if no slot can be added.
+// Swapping out a process's mapping of a shared frame copies the page to the slot and drops one
+// mapping; the frame is freed with its last.
+int swap_out_page(Frame* frames, Process* process, int page_number) {
+    int frame = process->page_table[page_number - 1];
+    int slot = disk_pool_alloc_slot(&disk);
+    if (slot < 0) {
+        printf("Error: Memory allocation failed; page %d of process %d stays in memory\n", page_number, process->process_id);
+        return -1;
+    }
+    int previous_phase = probe_enter(PROBE_SWAP);
+    if (frames[frame].huge) {
+        stats.huge_splits++;
+    }
+    mmu_invalidate(process, frames, page_number - 1);
+    DiskPage* disk_entry = disk_page(&disk, slot);
+    disk_entry->process_id = process->process_id;
+    disk_entry->page_number = page_number;
+    disk_entry->in_memory = 0;
+    disk_entry->content = 0;
+    disk_page_count++;
+    int in_tier = 0;
+    if (frame_data != NULL) {
+        unsigned char* data = frame_data + (size_t)frame * page_image_bytes;
+        memcpy(&disk_entry->content, data, sizeof(page_key));
+        in_tier = store_page_image(slot, data, process, page_number);
+    }
+    stats.swap_outs++; // An eviction, not a fault; the fault is counted where a reference takes it
+    if (in_tier == 1) {
+        if (paging_messages) {
+            printf("Swapping out page %d of process %d to the compressed tier\n", page_number, process->process_id);
+        }
+    } else {
+        stats.swap_time += device_service_ns(&timing_model) / 1000.0;
+        if (paging_messages) {
+            printf("Swapping out page %d of process %d to disk\n", page_number, process->process_id);
+        }
+    }
+
+    readahead_release(&frames[frame], process);
+    release_frame(frames, frame);
+    process->page_table[page_number - 1] = SWAP_SLOT_ENTRY(slot);
+    process->resident_pages--;
+    probe_leave(previous_phase);
+    return slot;
+}
+
+// Function to swap in a page from disk to RAM; returns its new frame, or -1 if no frame is free.
+// When the process's swap-in faults repeat the same stride, up to readahead_window more of its
+// swapped-out pages along that stride come in with the same batched read, using free frames only.
+int swap_in_page(Frame* frames, Process* process, int page_number) {
+    int pages[READAHEAD_MAX_PAGES + 1];
+    int count = 0;
+    pages[count++] = page_number;
+    int stride = process->last_fault_page > 0 ? page_number - process->last_fault_page : 0;
+    if (stride != 0 && stride == process->fault_stride) {
+        for (int next = page_number + stride; count <= process->readahead_window && next >= 1 &&
+             next <= process->page_table_size; next += stride) {
+            int entry = process->page_table[next - 1];
+            if (entry == PAGE_UNMAPPED) {
+                break;
+            }
+            if (PAGE_ON_DISK(entry)) {
+                pages[count++] = next;
+            }
+        }
+    }
+    process->fault_stride = stride;
+    process->last_fault_page = page_number;
+
+    int frame_list[READAHEAD_MAX_PAGES + 1];
+    if (count > frame_allocator.free_frames) {
+        count = frame_allocator.free_frames;
+    }
+    if (count == 0 || frame_allocator_alloc(&frame_allocator, count, frame_list) < count) {
+        printf("No free frame to swap in page %d of process %d\n", page_number, process->process_id);
+        return -1;
+    }
+    int previous_phase = probe_enter(PROBE_SWAP);
+
+    // Pages in the compressed tier are decompressed; the rest are read from disk in one batch
+    int in_tier[READAHEAD_MAX_PAGES + 1] = {0};
+    int disk_slots[READAHEAD_MAX_PAGES + 1];
+    unsigned char* disk_data[READAHEAD_MAX_PAGES + 1];
+    int from_disk = 0;
+    for (int i = 0; i < count; i++) {
+        int slot = ENTRY_SWAP_SLOT(process->page_table[pages[i] - 1]);
+        unsigned char* data = frame_data != NULL ? frame_data + (size_t)frame_list[i] * page_image_bytes : NULL;
+        in_tier[i] = data != NULL && compressed_pool.capacity_bytes > 0 ? compressed_pool_load(&compressed_pool, slot, data) : 0;
+        if (in_tier[i] != 1) {
+            disk_slots[from_disk] = slot;
+            disk_data[from_disk] = data;
+            from_disk++;
+        }
+    }
+    int file_read = 0;
+    if (frame_data != NULL && swap_file.fd >= 0 && from_disk > 0) {
+        file_read = swap_file_read_batch(&swap_file, disk_slots, disk_data, from_disk) == 0;
+        if (!file_read) {
+            // The frames would otherwise keep their previous occupants' bytes
+            printf("Error: Page %d of process %d could not be read back from the swap file; its contents are rebuilt\n",
+                   page_number, process->process_id);
+        }
+    }
+    if (from_disk > 0) {
+        stats.swap_time += device_batch_ns(&timing_model, from_disk) / 1000.0; // One request for the whole batch
+    }
+
+    for (int i = 0; i < count; i++) {
+        int slot = ENTRY_SWAP_SLOT(process->page_table[pages[i] - 1]);
+        int frame = frame_list[i];
+        if (frame_data != NULL) {
+            unsigned char* data = frame_data + (size_t)frame * page_image_bytes;
+            // Without a swap file, or when reading it failed, the page is rebuilt from its key
+            if (in_tier[i] != 1 && !file_read) {
+                swap_page_fill(data, page_image_bytes, disk_page(&disk, slot)->content);
+            }
+            if (!swap_page_verify(data, page_image_bytes, disk_page(&disk, slot)->content)) {
+                printf("Error: Page %d of process %d came back from swap with the wrong contents\n", pages[i], process->process_id);
+            }
+        }
+        disk_page(&disk, slot)->in_memory = 1; // Mark the page as loaded into memory
+        disk_pool_free_slot(&disk, slot);
+        disk_page_count--;
+
+        frames[frame].assigned = 1;
+        frames[frame].prefetched = i > 0;
+        frames[frame].process_id = process->process_id;
+        frames[frame].page_number = pages[i];
+        process->page_table[pages[i] - 1] = frame;
+        process->resident_pages++;
+    }
+    if (paging_messages) {
+        printf("Swapping in page %d of process %d from %s\n", page_number, process->process_id,
+               in_tier[0] == 1 ? "the compressed tier" : "disk");
+    }
+    stats.swap_ins += count;
+    if (count > 1) {
+        stats.prefetched_pages += count - 1;
+    }
+    if (count > 1 && paging_messages) {
+        printf("Read ahead %d more pages of process %d (stride %d, window %d)\n",
+               count - 1, process->process_id, stride, process->readahead_window);
+    }
+    probe_leave(previous_phase);
+    return frame_list[0];
+}
+
+// Function to let a process write a page it has in a frame. A write to a shared frame is a
+// copy-on-write fault: the page is copied to a frame of the writer's own, or, if the writer holds
+// the last mapping, the frame is simply taken over. The written page's contents become the
+// process's own. Returns the frame now holding the page, or -1 if no frame could be had for the copy.
+static int make_page_writable(Process* processes, int process_count, Frame* frames, Process* process, int page_number, int frame) {
+    if (frames[frame].process_id == SHARED_OWNER) {
+        stats.cow_faults++;
+        if (frames[frame].page_number == 1) {
+            page_scanner_forget(&page_scanner, frame);
+            frames[frame].process_id = process->process_id;
+            frames[frame].page_number = page_number;
+            stats.shared_frames--;
+            stats.shared_mappings--;
+            stats.cow_reuses++;
+        } else {
+            int copy;
+            if (frame_allocator.free_frames == 0) {
+                reclaim_frame(processes, process_count, frames, NULL, 0);
+            }
+            if (frame_allocator_alloc(&frame_allocator, 1, &copy) != 1) {
+                printf("No free frame to copy page %d of process %d on write\n", page_number, process->process_id);
+                return -1;
+            }
+            if (frame_data != NULL) {
+                memcpy(frame_data + (size_t)copy * page_image_bytes, frame_data + (size_t)frame * page_image_bytes, page_image_bytes);
+            }
+            mmu_invalidate(process, frames, page_number - 1);
+            release_frame(frames, frame);
+            frames[copy].assigned = 1;
+            frames[copy].prefetched = 0;
+            frames[copy].huge = 0;
+            frames[copy].process_id = process->process_id;
+            frames[copy].page_number = page_number;
+            process->page_table[page_number - 1] = copy;
+            stats.cow_copies++;
+            mmu_translate(process, frames, page_number - 1); // The faulting write is retried
+            frame = copy;
+        }
+    }
+    if (frame_data != NULL) {
+        unsigned char* data = frame_data + (size_t)frame * page_image_bytes;
+        page_key own = make_page_key((uint32_t)process->process_id, (uint32_t)page_number);
+        page_key stamp;
+        memcpy(&stamp, data, sizeof(stamp));
+        if (stamp != own) {
+            swap_page_fill(data, page_image_bytes, own);
+        }
+    }
+    return frame;
+}
+
+// Function to make one reference to a resident or swapped-out page of a process, swapping it in on
+// a fault; returns the frame holding the page, or -1 if it could not be brought in. The page's
+// last use in the process's virtual time feeds the working-set estimate.
+int reference_page(Process* processes, int process_count, Frame* frames, Process* process, int page_number, int write) {
+    if (telemetry.file != NULL && stats.references >= telemetry.next_sample) {
+        telemetry_sample(&telemetry);
+    }
+    stats.references++;
+    process->virtual_time++;
+    process->last_use[page_number - 1] = process->virtual_time;
+    load_control.window_references++;
+
+    // Every access is translated first; a walk that finds the page on disk ends in the fault below
+    mmu_translate(process, frames, page_number - 1);
+    int entry = process->page_table[page_number - 1];
+    if (entry >= 0 && frames[entry].prefetched) {
+        // A readahead hit: a fault avoided. The stream continues through it and the window grows.
+        frames[entry].prefetched = 0;
+        stats.prefetch_hits++;
+        process->last_fault_page = page_number;
+        if (process->readahead_window * 2 <= READAHEAD_MAX_PAGES) {
+            process->readahead_window *= 2;
+        }
+    }
+    int frame = entry;
+    if (frame < 0) {
+        // Page fault: with no free frame, the WSClock hand picks a victim from any process
+        int previous_phase = probe_enter(PROBE_REPLACEMENT);
+        stats.page_faults++;
+        stats.reference_faults++;
+        process->faults++;
+        load_control.window_faults++;
+        if (frame_allocator.free_frames == 0) {
+            reclaim_frame(processes, process_count, frames, NULL, 0);
+        }
+        frame = swap_in_page(frames, process, page_number);
+        probe_leave(previous_phase);
+        if (frame >= 0) {
+            mmu_translate(process, frames, page_number - 1); // The faulting access is retried
+        }
+    }
+    if (write && frame >= 0) {
+        frame = make_page_writable(processes, process_count, frames, process, page_number, frame);
+    }
+    return frame;
+}
+
+// Function to read or write one page of a process, as options 9 and 14 ask
+static void touch_page(Process* processes, int process_count, Frame* frames, int write) {
+    int process_id, page_number;
+    printf("Enter process ID: ");
+    scanf("%d", &process_id);
+    printf("Enter page number: ");
+    scanf("%d", &page_number);
+
+    Process* process = find_process(processes, process_count, process_id);
+    if (process == NULL || page_number < 1 || page_number > process->page_table_size ||
+        process->page_table[page_number - 1] == PAGE_UNMAPPED) {
+        printf("Page %d of process %d is not allocated\n", page_number, process_id);
+        return;
+    }
+    int entry = process->page_table[page_number - 1];
+    int prefetched = entry >= 0 && frames[entry].prefetched;
+    int shared = entry >= 0 && frames[entry].process_id == SHARED_OWNER;
+    int frame = reference_page(processes, process_count, frames, process, page_number, write);
+    const char* note = prefetched ? " (read ahead)" : "";
+    if (shared) {
+        note = !write ? " (shared)" : frame != entry ? " (copied on write)" : " (last mapping, taken over)";
+    }
+    if (frame >= 0) {
+        printf("Page %d of process %d is in frame %d%s\n", page_number, process_id, frame + 1, note);
+    }
+}
+
+// Function to access one page of a process, swapping it in from disk on a fault
+void access_page(Process* processes, int process_count, Frame* frames) {
+    touch_page(processes, process_count, frames, 0);
+}
+
+// Function to write one page of a process, copying it first if it is shared
+void write_page(Process* processes, int process_count, Frame* frames) {
+    touch_page(processes, process_count, frames, 1);
+}
+
+// Function to fork a process into an empty process slot. The child maps every resident page of
+// the parent; both mappings share the frame copy-on-write, as fork does. Huge pages are split
+// first, since a write to one would copy 2 MB. Swapped-out pages are copied to slots of the
+// child's own, written from the content recorded with the parent's slot.
+void fork_process(Process* processes, int process_count, Frame* frames) {
+    int parent_id, child_id;
+    printf("Enter process ID to fork: ");
+    scanf("%d", &parent_id);
+    printf("Enter process ID of the child (a process without memory): ");
+    scanf("%d", &child_id);
+    Process* parent = find_process(processes, process_count, parent_id);
+    Process* child = find_process(processes, process_count, child_id);
+    if (parent == NULL || child == NULL || parent == child || parent->page_table_size == 0) {
+        printf("Process %d cannot be forked into process %d\n", parent_id, child_id);
+        return;
+    }
+    if (child->page_table_size > 0 || child->object_count > 0) {
+        printf("Process %d still has memory; deallocate it first\n", child_id);
+        return;
+    }
+    unsigned char* scratch = NULL;
+    if (frame_data != NULL && (scratch = (unsigned char*)malloc(page_image_bytes)) == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        return;
+    }
+    int previous_phase = probe_enter(PROBE_ALLOCATION);
+    if (resize_page_table(frames, child, parent->page_table_size) != 0) {
+        probe_leave(previous_phase);
+        free(scratch);
+        return;
+    }
+    int shared = 0, copied = 0, complete = 1;
+    for (int j = 0; j < parent->page_table_size; j++) {
+        int entry = parent->page_table[j];
+        if (entry >= 0) {
+            mmu_invalidate(parent, frames, j); // The parent's mapping turns read-only
+            if (frames[entry].process_id == SHARED_OWNER) {
+                frames[entry].page_number++;
+            } else {
+                readahead_release(&frames[entry], parent);
+                frames[entry].process_id = SHARED_OWNER;
+                frames[entry].page_number = 2;
+                stats.shared_frames++;
+                stats.shared_mappings++;
+            }
+            stats.shared_mappings++;
+            child->page_table[j] = entry;
+            child->resident_pages++;
+            child->mapped_pages++;
+            shared++;
+        } else if (PAGE_ON_DISK(entry)) {
+            int slot = disk_pool_alloc_slot(&disk);
+            if (slot < 0) {
+                printf("Error: Memory allocation failed; the child has no copy of page %d\n", j + 1);
+                complete = 0;
+                break;
+            }
+            const DiskPage* source = disk_page(&disk, ENTRY_SWAP_SLOT(entry));
+            DiskPage* copy = disk_page(&disk, slot);
+            copy->process_id = child->process_id;
+            copy->page_number = j + 1;
+            copy->in_memory = 0;
+            copy->content = source->content;
+            disk_page_count++;
+            int in_tier = 0;
+            if (scratch != NULL) {
+                swap_page_fill(scratch, page_image_bytes, copy->content);
+                in_tier = store_page_image(slot, scratch, child, j + 1);
+            }
+            if (in_tier != 1) {
+                stats.swap_time += device_service_ns(&timing_model) / 1000.0;
+            }
+            child->page_table[j] = SWAP_SLOT_ENTRY(slot);
+            child->mapped_pages++;
+            stats.swap_outs++;
+            copied++;
+        }
+    }
+    probe_leave(previous_phase);
+    free(scratch);
+
+    child->memory_requirement = parent->memory_requirement;
+    child->allocated = complete;
+    child->state = complete ? RUNNING : WAITING;
+    child->virtual_time = 0;
+    child->faults = 0;
+    child->deferred = 0;
+    child->working_set = 0;
+    child->admitted_at = load_control.checks;
+    child->last_fault_page = 0;
+    child->fault_stride = 0;
+    child->readahead_window = READAHEAD_MIN_PAGES;
+    printf("Process %d forked into process %d: %d resident pages shared copy-on-write, %d swapped-out pages copied\n",
+           parent_id, child_id, shared, copied);
+}
+
+// Function to count a process's working set: its pages referenced in the last window references
+int working_set_size(const Process* process) {
+    int pages = 0;
+    for (int j = 0; j < process->page_table_size; j++) {
+        pages += process->last_use[j] > 0 && process->virtual_time - process->last_use[j] < load_control.window;
+    }
+    return pages;
+}
+
+// Function to free one frame by swapping out a page (WSClock). The hand passes over pages used
+// within their process's working-set window and takes the first page outside it; if every page
+// is in a working set, the least recently used one goes, unless working_set_only is set. Pages of
+// the requester are never taken. Returns the frame freed, or -1 if none could be.
+int reclaim_frame(Process* processes, int process_count, Frame* frames, const Process* requester, int working_set_only) {
+    int victim = -1, oldest = -1;
+    long long oldest_age = -1;
+    Process* victim_owner = NULL;
+    Process* oldest_owner = NULL;
+    for (int step = 0; step < total_frames && victim < 0; step++) {
+        int frame = load_control.hand;
+        load_control.hand = (frame + 1) % total_frames;
+        if (!frames[frame].assigned || frames[frame].process_id == SLAB_OWNER) {
+            continue;
+        }
+        Process* owner = find_process(processes, process_count, frames[frame].process_id);
+        if (owner == NULL || owner == requester) {
+            continue;
+        }
+        long long age = owner->virtual_time - owner->last_use[frames[frame].page_number - 1];
+        if (age >= load_control.window) {
+            victim = frame;
+            victim_owner = owner;
+        } else if (age > oldest_age) {
+            oldest = frame;
+            oldest_age = age;
+            oldest_owner = owner;
+        }
+    }
+    if (victim < 0 && !working_set_only) {
+        victim = oldest;
+        victim_owner = oldest_owner;
+    }
+    if (victim < 0 || swap_out_page(frames, victim_owner, frames[victim].page_number) < 0) {
+        return -1;
+    }
+    return victim;
+}
+
+// Function to suspend a process: its working set is noted and every resident page swapped out,
+// so its frames go to the processes still running
+void suspend_process(Frame* frames, Process* process) {
+    process->working_set = working_set_size(process);
+    for (int j = 0; j < process->page_table_size; j++) {
+        if (process->page_table[j] >= 0) {
+            swap_out_page(frames, process, j + 1);
+        }
+    }
+    process->state = SUSPENDED;
+    process->queued_at = load_control.checks;
+    load_control.suspensions++;
+    printf("Load control: suspended process %d (working set %d pages)\n", process->process_id, process->working_set);
+}
+
+// Function to count the pages a deferred process still needs mapped
+static int pages_to_admit(const Process* process, int page_size) {
+    int needed = required_pages(process->memory_requirement, page_size);
+    for (int j = 0; j < process->page_table_size && j < required_pages(process->memory_requirement, page_size); j++) {
+        needed -= process->page_table[j] != PAGE_UNMAPPED;
+    }
+    return needed;
+}
+
+// Function to admit processes waiting for frames whose pages now fit
+void admit_waiting_processes(Process* processes, int process_count, Frame* frames, int page_size) {
+    for (int i = 0; i < process_count; i++) {
+        Process* process = &processes[i];
+        if (process->deferred && process->state != COMPLETED &&
+            admission_room(processes, process_count, frames, process) >= pages_to_admit(process, page_size)) {
+            allocate_process_memory(processes, process_count, process, frames, page_size);
+        }
+    }
+}
+
+// Function to keep the multiprogramming level where the running working sets fit in memory
+// (Denning). The system is thrashing when their total exceeds the frames available to processes
+// and the fault rate since the last check is high; the running process with the largest working
+// set is then suspended. Otherwise the process that has waited longest is let in while it fits:
+// a suspended one when its working set fits, a deferred one when all its pages do. If it does
+// not fit, the process that has run longest is swapped out for it once it has had
+// LOAD_CONTROL_ROTATION checks, so no process waits forever.
+void load_control_check(Process* processes, int process_count, Frame* frames, int page_size) {
+    if (!load_control.enabled) {
+        return;
+    }
+    load_control.checks++;
+    int usable = total_frames - (int)(slab_allocator.slabs_created - slab_allocator.slabs_released);
+    int demand = 0, running = 0;
+    Process* largest = NULL;
+    Process* longest = NULL;
+    int largest_set = -1;
+    for (int i = 0; i < process_count; i++) {
+        Process* process = &processes[i];
+        if (process->state != RUNNING || !process->allocated) {
+            continue;
+        }
+        int working_set = working_set_size(process);
+        demand += working_set;
+        running++;
+        if (working_set > largest_set) {
+            largest = process;
+            largest_set = working_set;
+        }
+        if (longest == NULL || process->admitted_at < longest->admitted_at) {
+            longest = process;
+        }
+    }
+    double fault_rate = load_control.window_references > 0 ? (double)load_control.window_faults / load_control.window_references : 0;
+    load_control.window_references = 0;
+    load_control.window_faults = 0;
+
+    if (demand > usable && fault_rate > THRASH_FAULT_RATE) {
+        load_control.thrashing_windows++;
+        if (running > 1) {
+            suspend_process(frames, largest);
+        }
+        return;
+    }
+    for (;;) {
+        Process* next = NULL;
+        for (int i = 0; i < process_count; i++) {
+            Process* process = &processes[i];
+            if (process->state != COMPLETED && (process->state == SUSPENDED || process->deferred) &&
+                (next == NULL || process->queued_at < next->queued_at)) {
+                next = process;
+            }
+        }
+        if (next == NULL) {
+            return;
+        }
+        if (next->state == SUSPENDED && demand + next->working_set <= usable) {
+            next->state = RUNNING;
+            next->admitted_at = load_control.checks;
+            demand += next->working_set;
+            load_control.resumptions++;
+            printf("Load control: resumed process %d\n", next->process_id);
+            continue;
+        }
+        int needed = next->deferred ? pages_to_admit(next, page_size) : 0;
+        if (next->deferred && admission_room(processes, process_count, frames, next) >= needed) {
+            allocate_process_memory(processes, process_count, next, frames, page_size);
+            if (!next->deferred) {
+                demand += needed;
+                continue;
+            }
+        }
+
+        // The longest waiter does not fit: rotate if the process that has run longest has had its turn
+        // and swapping it out would make room
+        int fits = next->state == SUSPENDED ? next->working_set <= usable
+                                            : needed <= admission_room(processes, process_count, frames, next) + (longest != NULL ? longest->resident_pages : 0);
+        if (longest != NULL && fits && load_control.checks - longest->admitted_at >= LOAD_CONTROL_ROTATION) {
+            suspend_process(frames, longest);
+            load_control.rotations++;
+        }
+        return;
+    }
+}
+
+// Function to run the processes for a number of references: running processes take turns in
+// random quanta of 1 to 64 references, each over a Zipfian hot set of its pages, and
+// RUN_WRITE_PERCENT of references are writes. Load control is checked, and the page scanner given
+// its pages when it runs in the background, every LOAD_CONTROL_INTERVAL references. Throughput is
+// references per second of simulated time, a DRAM access per reference plus fault overhead and
+// swap device time.
+void run_processes(Process* processes, int process_count, Frame* frames, int page_size) {
+    long long references;
+    unsigned long long seed;
+    printf("Enter number of references: ");
+    scanf("%lld", &references);
+    printf("Enter seed: ");
+    scanf("%llu", &seed);
+    if (references <= 0) {
+        printf("Invalid number of references. Please enter a value greater than 0.\n");
+        return;
+    }
+    ZipfSampler* samplers = (ZipfSampler*)calloc(process_count, sizeof(ZipfSampler));
+    if (samplers == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        return;
+    }
+    uint64_t rng = seed;
+    for (int i = 0; i < process_count; i++) {
+        if (processes[i].page_table_size > 0 && zipf_init(&samplers[i], processes[i].page_table_size, 0.99, &rng) != 0) {
+            break;
+        }
+    }
+
+    long long faults_before = 0, suspensions_before = load_control.suspensions;
+    long long thrashing_before = load_control.thrashing_windows, rotations_before = load_control.rotations;
+    for (int i = 0; i < process_count; i++) {
+        faults_before += processes[i].faults;
+    }
+    double swap_before = stats.swap_time;
+    int cow_before = stats.cow_faults;
+    long long merged_before = page_scanner.merged;
+    double scanner_before = page_scanner.cpu_ns;
+    paging_messages = 0;
+    long long issued = 0;
+    int current = -1, quantum = 0;
+    while (issued < references) {
+        if (quantum == 0) {
+            // Pick the next process to run among the running ones that have pages
+            int candidates = 0;
+            for (int i = 0; i < process_count; i++) {
+                candidates += processes[i].state == RUNNING && samplers[i].rank_page != NULL;
+            }
+            if (candidates == 0) {
+                load_control_check(processes, process_count, frames, page_size);
+                for (int i = 0; i < process_count; i++) {
+                    candidates += processes[i].state == RUNNING && samplers[i].rank_page != NULL;
+                }
+                if (candidates == 0) {
+                    break;
+                }
+            }
+            int pick = (int)(workload_random(&rng) % (uint64_t)candidates);
+            for (current = 0; current < process_count; current++) {
+                if (processes[current].state == RUNNING && samplers[current].rank_page != NULL && pick-- == 0) {
+                    break;
+                }
+            }
+            quantum = 1 + (int)(workload_random(&rng) % 64);
+        }
+        Process* process = &processes[current];
+        int page_number = zipf_next(&samplers[current], &rng);
+        int write = (int)(workload_random(&rng) % 100) < RUN_WRITE_PERCENT;
+        if (page_number <= process->page_table_size && process->page_table[page_number - 1] != PAGE_UNMAPPED) {
+            reference_page(processes, process_count, frames, process, page_number, write);
+        }
+        issued++;
+        quantum--;
+        if (issued % LOAD_CONTROL_INTERVAL == 0) {
+            if (page_scanner.pages_per_check > 0) {
+                page_scanner_scan(processes, process_count, frames, page_scanner.pages_per_check);
+            }
+            load_control_check(processes, process_count, frames, page_size);
+            if (process->state != RUNNING) {
+                quantum = 0; // The running process was suspended
+            }
+        }
+    }
+    paging_messages = 1;
+
+    long long faults = -faults_before;
+    for (int i = 0; i < process_count; i++) {
+        faults += processes[i].faults;
+        zipf_free(&samplers[i]);
+    }
+    free(samplers);
+    double simulated_us = issued * timing_model.dram_hit_ns / 1000.0 + faults * timing_model.fault_overhead_ns / 1000.0 +
+                          (stats.swap_time - swap_before);
+    printf("Ran %lld references: %lld faults (%.2f%% fault rate), %.2f ms simulated, %.0f references/s\n", issued, faults,
+           issued > 0 ? 100.0 * faults / issued : 0.0, simulated_us / 1000.0, simulated_us > 0 ? issued / (simulated_us / 1e6) : 0.0);
+    printf("Load control %s: %lld checks found thrashing, %lld suspensions (%lld to rotate in a waiting process)\n",
+           load_control.enabled ? "on" : "off", load_control.thrashing_windows - thrashing_before,
+           load_control.suspensions - suspensions_before, load_control.rotations - rotations_before);
+    printf("Sharing: %d copy-on-write faults; %lld pages merged by the scanner in %.2f ms of CPU; %d frames saved\n",
+           stats.cow_faults - cow_before, page_scanner.merged - merged_before, (page_scanner.cpu_ns - scanner_before) / 1e6,
+           stats.shared_mappings - stats.shared_frames);
+}
+
+// Function to set up the page scanner over a frame table; pages_per_check > 0 also scans in the
+// background of process runs
+int page_scanner_init(PageScanner* scanner, int total_frames, int pages_per_check) {
+    memset(scanner, 0, sizeof(*scanner));
+    scanner->pages_per_check = pages_per_check;
+    scanner->checksums = (page_key*)calloc(total_frames, sizeof(page_key));
+    if (scanner->checksums == NULL || page_index_init(&scanner->stable, total_frames) != 0 ||
+        page_index_init(&scanner->unstable, total_frames) != 0) {
+        printf("Error: Memory allocation failed.\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Function to hash the contents of a page image
+static page_key page_content_hash(const unsigned char* data, size_t bytes) {
+    uint64_t hash = 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i + sizeof(uint64_t) <= bytes; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 29;
+    }
+    return hash != PAGE_KEY_NONE ? hash : 0;
+}
+
+// Function to move one private page onto a shared frame holding the same contents, freeing its frame
+static void merge_page(PageScanner* scanner, Frame* frames, Process* owner, int frame, int shared) {
+    int index = frames[frame].page_number - 1;
+    mmu_invalidate(owner, frames, index);
+    readahead_release(&frames[frame], owner);
+    frame_allocator_free(&frame_allocator, frame);
+    frames[frame].assigned = 0;
+    frames[frame].process_id = -1;
+    frames[frame].page_number = -1;
+    owner->page_table[index] = shared;
+    frames[shared].page_number++;
+    stats.shared_mappings++;
+    scanner->merged++;
+}
+
+// Function to scan one frame. A shared frame is entered in the stable index. A private page is
+// hashed; if the hash changed since the last pass the page is still being written and is left
+// alone. Otherwise it is merged with an identical shared page from the stable index, or with an
+// identical private page seen earlier in this pass from the unstable index, which then becomes a
+// shared frame. Hash matches are confirmed byte for byte.
+static void page_scanner_visit(PageScanner* scanner, Process* processes, int process_count, Frame* frames, int frame) {
+    if (!frames[frame].assigned || frames[frame].huge || frames[frame].process_id == SLAB_OWNER) {
+        return;
+    }
+    const unsigned char* data = frame_data + (size_t)frame * page_image_bytes;
+    if (frames[frame].process_id == SHARED_OWNER) {
+        // Shared frames never change, so one hash each is enough
+        if (page_index_find(&scanner->stable, scanner->checksums[frame]) != frame) {
+            page_key hash = page_content_hash(data, page_image_bytes);
+            scanner->checksums[frame] = hash;
+            scanner->scanned++;
+            if (page_index_find(&scanner->stable, hash) < 0) {
+                page_index_insert(&scanner->stable, hash, frame);
+            }
+        }
+        return;
+    }
+    Process* owner = find_process(processes, process_count, frames[frame].process_id);
+    if (owner == NULL) {
+        return;
+    }
+    page_key hash = page_content_hash(data, page_image_bytes);
+    scanner->scanned++;
+    if (hash != scanner->checksums[frame]) {
+        scanner->checksums[frame] = hash;
+        scanner->volatile_pages++;
+        return;
+    }
+    int shared = page_index_find(&scanner->stable, hash);
+    if (shared >= 0 && memcmp(frame_data + (size_t)shared * page_image_bytes, data, page_image_bytes) == 0) {
+        merge_page(scanner, frames, owner, frame, shared);
+        return;
+    }
+    int other = page_index_find(&scanner->unstable, hash);
+    if (other >= 0 && other != frame && frames[other].assigned && frames[other].process_id > SLAB_OWNER && !frames[other].huge &&
+        memcmp(frame_data + (size_t)other * page_image_bytes, data, page_image_bytes) == 0) {
+        // The earlier page's frame is shared from now on, and its owner's mapping stays as it is
+        page_index_remove(&scanner->unstable, hash);
+        frames[other].process_id = SHARED_OWNER;
+        frames[other].page_number = 1;
+        stats.shared_frames++;
+        stats.shared_mappings++;
+        scanner->checksums[other] = hash;
+        if (shared < 0) {
+            page_index_insert(&scanner->stable, hash, other);
+        }
+        merge_page(scanner, frames, owner, frame, other);
+        return;
+    }
+    page_index_insert(&scanner->unstable, hash, frame);
+}
+
+// Function to scan the next pages frames of the frame table, continuing where the last scan
+// stopped; the unstable index is emptied whenever the scan wraps round to frame 0
+void page_scanner_scan(Process* processes, int process_count, Frame* frames, int pages) {
+    PageScanner* scanner = &page_scanner;
+    if (scanner->checksums == NULL) {
+        return;
+    }
+    int previous_phase = probe_enter(PROBE_DEDUP);
+    struct timespec start, end;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+    for (int p = 0; p < pages; p++) {
+        page_scanner_visit(scanner, processes, process_count, frames, scanner->cursor);
+        if (++scanner->cursor == total_frames) {
+            scanner->cursor = 0;
+            scanner->passes++;
+            page_index_clear(&scanner->unstable);
+        }
+    }
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+    scanner->cpu_ns += (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+    probe_leave(previous_phase);
+}
+
+// Function to release the page scanner's indexes
+void page_scanner_free(PageScanner* scanner) {
+    page_index_free(&scanner->stable);
+    page_index_free(&scanner->unstable);
+    free(scanner->checksums);
+    scanner->checksums = NULL;
+}
+
+// Function to run the page scanner over the whole frame table until a pass merges nothing more.
+// The first pass only records checksums, so at least two are made.
+void merge_identical_pages(Process* processes, int process_count, Frame* frames) {
+    if (page_scanner.checksums == NULL) {
+        printf("Page merging compares page contents; start the simulator with --ksm-pages N, --swap-file or --zswap-mb\n");
+        return;
+    }
+    long long merged_before = page_scanner.merged, scanned_before = page_scanner.scanned;
+    double cpu_before = page_scanner.cpu_ns;
+    int passes = 0;
+    long long merged;
+    do {
+        merged = page_scanner.merged;
+        page_scanner_scan(processes, process_count, frames, total_frames);
+        passes++;
+    } while (passes < 2 || page_scanner.merged > merged);
+    printf("Merged %lld pages in %d passes over %lld pages hashed, %.2f ms scanner CPU; %d shared frames hold %d mappings (%d frames saved)\n",
+           page_scanner.merged - merged_before, passes, page_scanner.scanned - scanned_before, (page_scanner.cpu_ns - cpu_before) / 1e6,
+           stats.shared_frames, stats.shared_mappings, stats.shared_mappings - stats.shared_frames);
+}
+
+// Function to deallocate memory for a process
+void deallocate_memory(Frame* frames, int total_frames, Process* processes, int process_count, int process_id) {
+    Process* process = find_process(processes, process_count, process_id);
+    if (process == NULL) {
+        printf("Process %d not found\n", process_id);
+        return;
+    }
+    // Only this process's page table is walked, not the whole frame table
+    for (int i = 0; i < process->page_table_size; i++) {
+        unmap_page(frames, process, i);
+    }
+    free_process_objects(process, frames);
+    mmu_flush_process(&mmu, process_id);
+    free(process->page_table);
+    free(process->last_use);
+    process->page_table = NULL;
+    process->last_use = NULL;
+    process->page_table_size = 0;
+    process->allocated = 0;
+    process->deferred = 0; // A process still waiting for frames must not be admitted after it ends
+    process->queued_at = 0;
+    process->state = COMPLETED;
+    printf("Memory deallocated for process %d\n", process_id);
+}
+
+// Function to request additional memory
+void request_additional_memory(Process* processes, int process_count, Frame* frames, int total_frames, int page_size) {
+    int process_id, additional_memory;
+    printf("Enter process ID to request additional memory: ");
+    scanf("%d", &process_id);
+    printf("Enter additional memory required (in KB): ");
+    scanf("%d", &additional_memory);
+
+    // Only the growing process is revisited; its page table knows which pages are already mapped
+    Process* process = find_process(processes, process_count, process_id);
+    if (process != NULL) {
+        process->memory_requirement += additional_memory;
+        int previous_phase = probe_enter(PROBE_ALLOCATION);
+        allocate_process_memory(processes, process_count, process, frames, page_size);
+        probe_leave(previous_phase);
+    }
+}
+
+// Function to tell whether a frame continues the run of the frame before it in the memory map:
+// the same status and, for process pages, the same process and the next page
+static int frame_continues_run(const Frame* previous, const Frame* frame) {
+    if (!frame->assigned || frame->process_id != previous->process_id || frame->huge != previous->huge) {
+        return 0;
+    }
+    if (frame->process_id == SLAB_OWNER) {
+        return 1;
+    }
+    if (frame->process_id == SHARED_OWNER) {
+        return frame->page_number == previous->page_number; // Page number counts the mappings here
+    }
+    return frame->page_number == previous->page_number + 1;
+}
+
+// Function to format a range of numbers as "first-last", or one number alone
+static void format_range(char* text, size_t size, int first, int last) {
+    if (first == last) {
+        snprintf(text, size, "%d", first);
+    } else {
+        snprintf(text, size, "%d-%d", first, last);
+    }
+}
+
+// Function to display the memory map run-length encoded: one line per run of frames with the
+// same status and, for process pages, consecutive pages of one process. Free runs are found in
+// the free-frame bitmap a word at a time. At most MEMORY_MAP_MAX_RUNS runs are shown, and the
+// closing totals come from counters, so the output stays the same size however many frames there are.
+void display_memory_map(Frame* frames, int total_frames) {
+    printf("\nMemory Map:\n");
+    printf("Frames          Status          Process ID      Pages\n");
+    printf("-------------------------------------------------\n");
+    int start = 0;
+    for (int runs = 0; start < total_frames && runs < MEMORY_MAP_MAX_RUNS; runs++) {
+        const Frame* first = &frames[start];
+        int end = start + 1;
+        if (!first->assigned) {
+            end = frame_allocator_free_run_end(&frame_allocator, start);
+        } else {
+            while (end < total_frames && frame_continues_run(&frames[end - 1], &frames[end])) {
+                end++;
+            }
+        }
+        char frame_range[32], process_text[16], page_range[32];
+        format_range(frame_range, sizeof(frame_range), start + 1, end);
+        const char* status = "Assigned";
+        snprintf(process_text, sizeof(process_text), "N/A");
+        snprintf(page_range, sizeof(page_range), "N/A");
+        if (!first->assigned) {
+            status = "Free";
+        } else if (first->process_id == SLAB_OWNER) {
+            status = "Slab";
+        } else if (first->process_id == SHARED_OWNER) {
+            status = "Shared";
+            snprintf(page_range, sizeof(page_range), "%d mappings", first->page_number);
+        } else {
+            status = first->huge ? "Huge" : "Assigned";
+            snprintf(process_text, sizeof(process_text), "%d", first->process_id);
+            format_range(page_range, sizeof(page_range), first->page_number, first->page_number + (end - start) - 1);
+        }
+        printf("%-15s %-15s %-15s %s\n", frame_range, status, process_text, page_range);
+        start = end;
+    }
+    if (start < total_frames) {
+        printf("... frames %d-%d not shown\n", start + 1, total_frames);
+    }
+    printf("-------------------------------------------------\n");
+    int slab_frames = (int)(slab_allocator.slabs_created - slab_allocator.slabs_released);
+    printf("%d frames: %d in use (%d slab, %d shared, %d in huge pages), %d free\n", total_frames,
+           total_frames - frame_allocator.free_frames, slab_frames, stats.shared_frames,
+           stats.huge_pages * HUGE_PAGE_PAGES, frame_allocator.free_frames);
+}
+
+// Function to display active processes
+void display_processes(Process* processes, int process_count) {
+    printf("\nActive Processes:\n");
+    for (int i = 0; i < process_count; i++) {
+        printf("Process %d - Memory Required: %d KB, State: %d\n",
+                processes[i].process_id, processes[i].memory_requirement, processes[i].state);
+    }
+}
+
+// Function to count the bytes a process asked for (its mapped share of memory_requirement plus its
+// small objects) and the bytes of the whole pages mapped for it
+static void process_byte_usage(const Process* process, size_t page_bytes, long long* requested, long long* page_consumed) {
+    *page_consumed = (long long)process->mapped_pages * (long long)page_bytes;
+    long long page_requested = (long long)process->memory_requirement * 1024;
+    *requested = (page_requested < *page_consumed ? page_requested : *page_consumed) + process->object_bytes_requested;
+}
+
+// Function to count the page-table pages a process's radix table needs: one per 512 entries at
+// each level, except that a huge page is a page-directory leaf with no page table below it
+static long long page_table_pages(const Process* process) {
+    if (process->page_table_size == 0) {
+        return 0;
+    }
+    long long pages = 0;
+    long long entries = process->page_table_size;
+    for (int level = PAGE_TABLE_LEVELS - 1; level >= 0; level--) {
+        long long tables = (entries + HUGE_PAGE_PAGES - 1) / HUGE_PAGE_PAGES;
+        pages += tables;
+        entries = tables;
+    }
+    return pages - process->huge_regions;
+}
+
+// Function to print memory usage statistics
+void print_memory_usage(Frame* frames, int total_frames, int page_size, Process* processes, int process_count) {
+    // Every figure is kept up to date as frames and pages change hands, so no pass over the frame
+    // table or the page tables is needed: frame counts and the longest free run come from the
+    // free-frame bitmap, and each process counts its mapped pages and huge regions
+    int free_frames = frame_allocator.free_frames;
+    int used_frames = total_frames - free_frames;
+    int total_memory = total_frames * page_size;
+    int used_memory = used_frames * page_size;
+
+    int free_memory = total_memory - used_memory;
+    double memory_utilization = ((double)used_memory / total_memory) * 100;
+
+    // External fragmentation: share of the free frames outside the largest contiguous free run
+    int largest_run = frame_allocator_largest_run(&frame_allocator);
+    double exf = free_frames > 0 ? 100 - ((double)largest_run / free_frames) * 100 : 0;
+
+    // Internal fragmentation: bytes the processes asked for against the bytes set aside for them.
+    // Pages round each process up to whole pages; objects are rounded up to their size class, and
+    // the unused slots of slabs count as consumed by no one.
+    size_t page_bytes = (size_t)page_size * 1024;
+    long long requested_bytes = 0, consumed_bytes = 0;
+    for (int i = 0; i < process_count; i++) {
+        long long requested, page_consumed;
+        process_byte_usage(&processes[i], page_bytes, &requested, &page_consumed);
+        requested_bytes += requested;
+        consumed_bytes += page_consumed;
+    }
+    consumed_bytes += (slab_allocator.slabs_created - slab_allocator.slabs_released) * (long long)page_bytes;
+    double inf = consumed_bytes > 0 ? 100 - ((double)requested_bytes / consumed_bytes) * 100 : 0;
+
+    // Display memory usage statistics
+    printf("\nMemory Usage Statistics:\n");
+    printf("Total Frames: %d\n", total_frames);
+    printf("Used Frames: %d\n", used_frames);
+    printf("Free Frames: %d\n", free_frames);
+    printf("Total Memory: %d KB\n", total_memory);
+    printf("Used Memory: %d KB\n", used_memory);
+    printf("Free Memory: %d KB\n", free_memory);
+    printf("External Fragmentation: %.2lf %% (largest free run %d of %d free frames)\n", exf, largest_run, free_frames);
+    printf("Internal Fragmentation: %.2lf %% (%lld bytes requested, %lld bytes consumed)\n", inf, requested_bytes, consumed_bytes);
+    printf("Memory Utilization: %.2f%%\n", memory_utilization);
+    printf("Total Page Faults: %d\n", stats.page_faults);
+    printf("Swap Time: %.2f us (%s)\n", stats.swap_time, timing_model.device->name);
+    printf("Swap Traffic: %lld pages out, %lld pages in; %lld references, %.2f%% found their page on disk\n",
+           stats.swap_outs, stats.swap_ins, stats.references,
+           stats.references > 0 ? 100.0 * stats.reference_faults / stats.references : 0.0);
+    printf("Readahead: %d pages prefetched, %d used (%.2f%% accuracy), %d wasted\n", stats.prefetched_pages,
+           stats.prefetch_hits, stats.prefetched_pages > 0 ? 100.0 * stats.prefetch_hits / stats.prefetched_pages : 0.0,
+           stats.prefetch_wasted);
+    printf("Load Control: %s, %d-reference working-set window; %lld deferred, %lld admitted later, %lld suspended "
+           "(%lld to rotate), %lld resumed, %lld of %lld checks found thrashing\n", load_control.enabled ? "on" : "off",
+           load_control.window, load_control.deferrals, load_control.admissions, load_control.suspensions,
+           load_control.rotations, load_control.resumptions, load_control.thrashing_windows, load_control.checks);
+    printf("TLB: %lld lookups, %.2f%% hit rate (%lld in the huge-page array); %d-entry base and %d-entry huge arrays, %d-way\n",
+           stats.tlb_lookups, stats.tlb_lookups > 0 ? 100.0 * stats.tlb_hits / stats.tlb_lookups : 0.0, stats.huge_tlb_hits,
+           mmu.base.sets * mmu.base.ways, mmu.huge.sets * mmu.huge.ways, mmu.base.ways);
+    printf("Page Walks: %lld, %.2f levels on average (%lld started from the walk caches)\n", stats.page_walks,
+           stats.page_walks > 0 ? (double)stats.walk_levels / stats.page_walks : 0.0, stats.walk_cache_hits);
+    printf("Translation Overhead: %.2f us (%.2f ns per access)\n", stats.translation_ns / 1000.0,
+           stats.tlb_lookups > 0 ? stats.translation_ns / stats.tlb_lookups : 0.0);
+    long long table_pages = 0;
+    for (int i = 0; i < process_count; i++) {
+        table_pages += page_table_pages(&processes[i]);
+    }
+    printf("Huge Pages: %d mapped, %d split by swap-out; page tables take %lld pages\n", stats.huge_pages, stats.huge_splits, table_pages);
+    printf("Sharing: %d shared frames hold %d mappings (%d frames saved); %d copy-on-write faults, %d copied, %d taken over by the last mapping\n",
+           stats.shared_frames, stats.shared_mappings, stats.shared_mappings - stats.shared_frames, stats.cow_faults,
+           stats.cow_copies, stats.cow_reuses);
+    if (page_scanner.checksums != NULL) {
+        printf("Page Merging: %lld pages merged; %lld passes hashed %lld pages, %lld skipped as still changing; "
+               "%.2f ms scanner CPU (%.0f ns per page)\n", page_scanner.merged, page_scanner.passes, page_scanner.scanned,
+               page_scanner.volatile_pages, page_scanner.cpu_ns / 1e6,
+               page_scanner.scanned > 0 ? page_scanner.cpu_ns / page_scanner.scanned : 0.0);
+    }
+    printf("Per process (objects counted at their size class):\n");
+    for (int i = 0; i < process_count; i++) {
+        const Process* process = &processes[i];
+        long long requested, page_consumed;
+        process_byte_usage(process, page_bytes, &requested, &page_consumed);
+        long long consumed = page_consumed + process->object_bytes_consumed;
+        printf("  Process %d: %lld bytes requested, %lld bytes consumed (%.2f%% internal fragmentation), %d small objects\n",
+               process->process_id, requested, consumed, consumed > 0 ? 100 - 100.0 * requested / consumed : 0.0,
+               process->object_count);
+    }
+    if (slab_allocator.slabs_created > 0) {
+        slab_report(&slab_allocator);
+    }
+    if (compressed_pool.capacity_bytes > 0) {
+        compressed_pool_report(&compressed_pool.stats, device_service_ns(&timing_model));
+    }
+    if (swap_file.fd >= 0) {
+        swap_file_report(&swap_file);
+    }
+}
+
+// Function to start a telemetry log: a CSV file, or binary records for a path ending in .bin
+int telemetry_open(Telemetry* log, const char* path, long long interval) {
+    memset(log, 0, sizeof(*log));
+    log->file = fopen(path, "wb");
+    if (log->file == NULL) {
+        printf("Error: Could not open %s for writing.\n", path);
+        return 1;
+    }
+    size_t length = strlen(path);
+    log->binary = length >= 4 && strcmp(path + length - 4, ".bin") == 0;
+    log->interval = interval;
+    log->next_sample = interval;
+    if (log->binary) {
+        uint32_t record_bytes = sizeof(TelemetryRecord);
+        fwrite("MSTL", 1, 4, log->file);
+        fwrite(&record_bytes, sizeof(record_bytes), 1, log->file);
+    } else {
+        fprintf(log->file, "references,used_frames,utilization,fault_rate,swap_outs,swap_ins,disk_pages,shared_frames,swap_time_us\n");
+    }
+    return 0;
+}
+
+// Function to write one sample from the running counters; fault rate and swap traffic cover the
+// references since the previous sample. Nothing is scanned, so a sample costs the same at any size.
+void telemetry_sample(Telemetry* log) {
+    TelemetryRecord record;
+    long long references = stats.references - log->last.references;
+    record.references = stats.references;
+    record.used_frames = frame_allocator.total_frames - frame_allocator.free_frames;
+    record.shared_frames = stats.shared_frames;
+    record.disk_pages = disk_page_count;
+    record.swap_outs = stats.swap_outs - log->last_swap_outs;
+    record.swap_ins = stats.swap_ins - log->last_swap_ins;
+    record.utilization = frame_allocator.total_frames > 0 ? (double)record.used_frames / frame_allocator.total_frames : 0;
+    record.fault_rate = references > 0 ? (double)(stats.reference_faults - log->last_faults) / references : 0;
+    record.swap_time_us = stats.swap_time;
+    if (log->binary) {
+        fwrite(&record, sizeof(record), 1, log->file);
+    } else {
+        fprintf(log->file, "%lld,%lld,%.6f,%.6f,%lld,%lld,%lld,%lld,%.3f\n", (long long)record.references,
+                (long long)record.used_frames, record.utilization, record.fault_rate, (long long)record.swap_outs,
+                (long long)record.swap_ins, (long long)record.disk_pages, (long long)record.shared_frames, record.swap_time_us);
+    }
+    log->last = record;
+    log->last_faults = stats.reference_faults;
+    log->last_swap_outs = stats.swap_outs;
+    log->last_swap_ins = stats.swap_ins;
+    log->samples++;
+    log->next_sample = stats.references + log->interval;
+}
+
+// Function to finish a telemetry log with a sample of the references since the last one
+void telemetry_close(Telemetry* log) {
+    if (log->file == NULL) {
+        return;
+    }
+    if (stats.references > log->last.references || log->samples == 0) {
+        telemetry_sample(log);
+    }
+    if (fclose(log->file) != 0) {
+        printf("Error: Could not write the telemetry log.\n");
+    }
+    log->file = NULL;
+    printf("Telemetry: %lld samples, one every %lld references\n", log->samples, log->interval);
+}
+
+int performance_matrix()
+{
+    Trace trace = {NULL, 0, 0};
+    double fifo_metrics[8], lru_metrics[8]; // Metrics for both algorithms
+
+    // Input frame count
+
+    if (total_frames <= 0) {
+        printf("Invalid frame count. Please enter a value greater than 0.\n");
+        return 1;
+    }
+
+    // Input page count
+
+    if (process_count <= 0) {
+        printf("Invalid page count. Please enter a value greater than 0.\n");
+        return 1;
+    }
+
+    // Input page requests
+    for (int i = 0; i < process_count; i++) {
+        if (trace_append(&trace, 1, i + 1, 0) != 0) {
+            trace_free(&trace);
+            return 1;
+        }
+    }
+
+    // Times come from the virtual clock: DRAM hits plus device transfers at the configured page size
+    TimingModel timing = timing_model;
+    timing.page_kb = page_size;
+    for (int algo = 0; algo < 2; algo++) {
+        const ReplacementPolicy* policy = find_policy(algo == 0 ? "FIFO" : "LRU");
+        ReplayResult result;
+
+        if (replay_trace(&trace, total_frames, policy, &timing, 0, &result) != 0) {
+            trace_free(&trace);
+            return 1;
+        }
+
+        double allocation_time = result.virtual_time_us;
+        int page_faults = (int)result.page_faults;
+
+        // Simulate deallocation delay
+        double deallocation_time = allocation_time * 0.2;
+
+        // Store performance metrics
+        double memory_utilization = ((double)(process_count < total_frames ? process_count : total_frames) / total_frames) * 100.0;
+        int largest_run = frame_allocator.words != NULL ? frame_allocator_largest_run(&frame_allocator) : 0;
+        double fragmentation = frame_allocator.free_frames > 0 ? 1 - (double)largest_run / frame_allocator.free_frames : 0;
+        double throughput = process_count / (allocation_time / 1000000.0);
+        double response_time = result.mean_latency_us;
+        double thrashing_rate = (double)page_faults / process_count;
+        double overhead = allocation_time * 0.1;
+
+        double *metrics = algo == 0 ? fifo_metrics : lru_metrics;
+        metrics[0] = memory_utilization;
+        metrics[1] = fragmentation;
+        metrics[2] = allocation_time;
+        metrics[3] = deallocation_time;
+        metrics[4] = throughput;
+        metrics[5] = response_time;
+        metrics[6] = thrashing_rate;
+        metrics[7] = overhead;
+    }
+    trace_free(&trace);
+
+    // Display performance matrix
+    printf("+-----------------------------+---------------+---------------+\n");
+    printf("| Entity                      | FIFO          | LRU           |\n");
+    printf("+-----------------------------+---------------+---------------+\n");
+    printf("| Fragmentation(%%)            | %13.2f | %13.2f |\n", fifo_metrics[1]*100, lru_metrics[1]*100);
+    printf("| Allocation Time (micros)    | %13.2f | %13.2f |\n", fifo_metrics[2], lru_metrics[2]);
+    printf("| Deallocation Time (micros)  | %13.2f | %13.2f |\n", fifo_metrics[3], lru_metrics[3]);
+    printf("| Throughput (pages/s)        | %13.2f | %13.2f |\n", fifo_metrics[4], lru_metrics[4]);
+    printf("| Response Time (micros)      | %13.2f | %13.2f |\n", fifo_metrics[5], lru_metrics[5]);
+    printf("| Thrashing Rate              | %13.2f | %13.2f |\n", fifo_metrics[6], lru_metrics[6]);
+    printf("| Overhead (micros)           | %13.2f | %13.2f |\n", fifo_metrics[7], lru_metrics[7]);
+    printf("+-----------------------------+---------------+---------------+\n");
+    return 0;
+}
+
+// Function to build the key of a trace record once its pages are grouped 2^page_shift at a time
+static inline page_key trace_page_key(const TraceRecord* record, int page_shift) {
+    return make_page_key(record->process_id, record->page_number >> page_shift);
+}
+
+// Function to build the key identifying one virtual page of one process
+page_key make_page_key(uint32_t process_id, uint32_t page_number) {
+    return ((page_key)process_id << 32) | page_number;
+}
+
+// Function to append one reference to a trace, growing the record array as needed
+int trace_append(Trace* trace, uint32_t process_id, uint32_t page_number, uint8_t write) {
+    if (trace->count == trace->capacity) {
+        size_t capacity = trace->capacity == 0 ? 65536 : trace->capacity * 2;
+        TraceRecord* records = (TraceRecord*)realloc(trace->records, capacity * sizeof(TraceRecord));
+        if (records == NULL) {
+            printf("Error: Memory allocation failed.\n");
+            return 1;
+        }
+        trace->records = records;
+        trace->capacity = capacity;
+    }
+    TraceRecord* record = &trace->records[trace->count++];
+    record->process_id = process_id;
+    record->page_number = page_number;
+    record->write = write;
+    return 0;
+}
+
+// Function to parse one unsigned 32-bit trace field; a sign or a value above UINT32_MAX is malformed
+static int parse_trace_field(char** cursor, uint32_t* value) {
+    if (**cursor < '0' || **cursor > '9') {
+        return 1;
+    }
+    char* end;
+    unsigned long long parsed = strtoull(*cursor, &end, 10);
+    if (parsed > UINT32_MAX) {
+        return 1;
+    }
+    *value = (uint32_t)parsed;
+    *cursor = end;
+    return 0;
+}
+
+// Function to parse one "pid vpage [r|w]" trace line; blank lines and '#' comments are skipped
+static int parse_trace_line(char* line, Trace* trace) {
+    char* cursor = line;
+    while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r') {
+        cursor++;
+    }
+    if (*cursor == '\0' || *cursor == '#') {
+        return 0;
+    }
+
+    uint32_t process_id, page_number;
+    if (parse_trace_field(&cursor, &process_id) != 0) {
+        return 1;
+    }
+    while (*cursor == ' ' || *cursor == '\t' || *cursor == ',') {
+        cursor++;
+    }
+    if (parse_trace_field(&cursor, &page_number) != 0) {
+        return 1;
+    }
+    // The all-ones pair would form PAGE_KEY_NONE, which marks an empty frame
+    if (make_page_key(process_id, page_number) == PAGE_KEY_NONE) {
+        return 1;
+    }
+    while (*cursor == ' ' || *cursor == '\t' || *cursor == ',') {
+        cursor++;
+    }
+
+    uint8_t write = 0;
+    if (*cursor == 'w' || *cursor == 'W') {
+        write = 1;
+    } else if (*cursor != 'r' && *cursor != 'R' && *cursor != '\0' && *cursor != '\r') {
+        return 1;
+    }
+    return trace_append(trace, process_id, page_number, write);
+}
+
+// Function to load a page-reference trace, reading the file in large chunks
+int trace_load(const char* path, Trace* trace) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        printf("Error: Could not open trace file %s\n", path);
+        return 1;
+    }
+    char* buffer = (char*)malloc(TRACE_CHUNK_SIZE + 1);
+    if (buffer == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        fclose(file);
+        return 1;
+    }
+
+    size_t carry = 0;          // Bytes of an unfinished line kept from the previous chunk
+    long long line_number = 0;
+    int status = 0;
+    int at_eof = 0;
+
+    while (!at_eof && status == 0) {
+        size_t wanted = TRACE_CHUNK_SIZE - carry;
+        size_t got = fread(buffer + carry, 1, wanted, file);
+        size_t length = carry + got;
+        at_eof = got < wanted;
+
+        size_t start = 0;
+        while (start < length) {
+            char* newline = (char*)memchr(buffer + start, '\n', length - start);
+            size_t end;
+            if (newline != NULL) {
+                end = (size_t)(newline - buffer);
+            } else if (at_eof) {
+                end = length; // Last line without a trailing newline
+            } else {
+                break;
+            }
+            buffer[end] = '\0';
+            line_number++;
+            if (parse_trace_line(buffer + start, trace) != 0) {
+                printf("Error: Malformed trace record at line %lld\n", line_number);
+                status = 1;
+                break;
+            }
+            start = end + 1;
+        }
+
+        carry = start < length ? length - start : 0;
+        if (carry == TRACE_CHUNK_SIZE) {
+            printf("Error: Trace line %lld is too long\n", line_number + 1);
+            status = 1;
+        }
+        memmove(buffer, buffer + start, carry);
+    }
+
+    free(buffer);
+    fclose(file);
+    if (status != 0) {
+        trace_free(trace);
+    }
+    return status;
+}
+
+// Function to release the records of a trace
+void trace_free(Trace* trace) {
+    free(trace->records);
+    trace->records = NULL;
+    trace->count = 0;
+    trace->capacity = 0;
+}
+
+// Function to draw the next value of a seeded generator (splitmix64), so every workload is reproducible
+uint64_t workload_random(uint64_t* state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Function to draw a uniform double in [0, 1)
+static double workload_uniform(uint64_t* state) {
+    return (workload_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Function to set up a Zipfian sampler over pages 1..pages (Gray et al.'s method, as in YCSB).
+// Popularity ranks are shuffled onto pages so the hot set is not one contiguous run.
+int zipf_init(ZipfSampler* zipf, int pages, double theta, uint64_t* rng) {
+    zipf->pages = pages;
+    zipf->theta = theta;
+    zipf->rank_page = (int*)malloc(pages * sizeof(int));
+    if (zipf->rank_page == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        return 1;
+    }
+    double zeta_n = 0;
+    for (int i = 1; i <= pages; i++) {
+        zeta_n += 1.0 / pow(i, theta);
+        zipf->rank_page[i - 1] = i;
+    }
+    for (int i = pages - 1; i > 0; i--) {
+        int j = (int)(workload_random(rng) % (uint64_t)(i + 1));
+        int page = zipf->rank_page[i];
+        zipf->rank_page[i] = zipf->rank_page[j];
+        zipf->rank_page[j] = page;
+    }
+    double zeta_2 = 1.0 + 1.0 / pow(2, theta);
+    zipf->zeta_n = zeta_n;
+    zipf->alpha = 1.0 / (1.0 - theta);
+    zipf->eta = (1.0 - pow(2.0 / pages, 1.0 - theta)) / (1.0 - zeta_2 / zeta_n);
+    return 0;
+}
+
+// Function to draw one page from a Zipfian sampler
+int zipf_next(const ZipfSampler* zipf, uint64_t* rng) {
+    double u = workload_uniform(rng);
+    double uz = u * zipf->zeta_n;
+    long rank;
+    if (uz < 1.0) {
+        rank = 0;
+    } else if (uz < 1.0 + pow(0.5, zipf->theta)) {
+        rank = 1;
+    } else {
+        rank = (long)(zipf->pages * pow(zipf->eta * u - zipf->eta + 1.0, zipf->alpha));
+    }
+    if (rank >= zipf->pages) {
+        rank = zipf->pages - 1;
+    }
+    return zipf->rank_page[rank];
+}
+
+void zipf_free(ZipfSampler* zipf) {
+    free(zipf->rank_page);
+    zipf->rank_page = NULL;
+}
+
+// Function to append one generated reference, writing with the workload's write ratio
+static int workload_emit(Trace* trace, const WorkloadParams* params, uint64_t* rng, uint32_t process_id, int page) {
+    return trace_append(trace, process_id, (uint32_t)page, workload_uniform(rng) < params->write_ratio);
+}
+
+// Zipfian hot set: one process, page popularity falling off as 1/rank^theta
+static int generate_zipf(Trace* trace, const WorkloadParams* params) {
+    uint64_t rng = params->seed;
+    ZipfSampler zipf;
+    if (zipf_init(&zipf, params->pages, params->zipf_theta, &rng) != 0) {
+        return 1;
+    }
+    int status = 0;
+    for (size_t i = 0; i < params->references && status == 0; i++) {
+        status = workload_emit(trace, params, &rng, 1, zipf_next(&zipf, &rng));
+    }
+    zipf_free(&zipf);
+    return status;
+}
+
+// Looping scan: one process sweeps all its pages in order, again and again. With more pages than
+// frames, LRU and FIFO miss on every reference while OPT keeps most of the loop.
+static int generate_loop(Trace* trace, const WorkloadParams* params) {
+    uint64_t rng = params->seed;
+    int status = 0;
+    for (size_t i = 0; i < params->references && status == 0; i++) {
+        status = workload_emit(trace, params, &rng, 1, (int)(i % params->pages) + 1);
+    }
+    return status;
+}
+
+// Phase-shifting working set: the process works uniformly within one eighth of its pages, then
+// moves to the next eighth, WORKLOAD_PHASES times over the run
+static int generate_phases(Trace* trace, const WorkloadParams* params) {
+    uint64_t rng = params->seed;
+    int set_pages = params->pages / WORKLOAD_PHASES > 0 ? params->pages / WORKLOAD_PHASES : 1;
+    size_t phase_length = params->references / WORKLOAD_PHASES > 0 ? params->references / WORKLOAD_PHASES : 1;
+    int status = 0;
+    for (size_t i = 0; i < params->references && status == 0; i++) {
+        int base = (int)((i / phase_length) % WORKLOAD_PHASES) * set_pages;
+        status = workload_emit(trace, params, &rng, 1, base + (int)(workload_random(&rng) % set_pages) + 1);
+    }
+    return status;
+}
+
+// Multi-process interleaving: each process has its own Zipfian hot set and runs for a random
+// quantum of 1 to 64 references before another process is picked
+static int generate_interleave(Trace* trace, const WorkloadParams* params) {
+    uint64_t rng = params->seed;
+    ZipfSampler zipf;
+    if (zipf_init(&zipf, params->pages, params->zipf_theta, &rng) != 0) {
+        return 1;
+    }
+    int status = 0;
+    size_t i = 0;
+    while (i < params->references && status == 0) {
+        uint32_t process_id = 1 + (uint32_t)(workload_random(&rng) % params->processes);
+        int quantum = 1 + (int)(workload_random(&rng) % 64);
+        for (int q = 0; q < quantum && i < params->references && status == 0; q++, i++) {
+            status = workload_emit(trace, params, &rng, process_id, zipf_next(&zipf, &rng));
+        }
+    }
+    zipf_free(&zipf);
+    return status;
+}
+
+// Fork-like bursts: a parent works on a Zipfian hot set and, about every 4096 references, forks a
+// child that writes a copy of a window of the parent's pages and exits, leaving only cold pages
+static int generate_fork(Trace* trace, const WorkloadParams* params) {
+    uint64_t rng = params->seed;
+    ZipfSampler zipf;
+    if (zipf_init(&zipf, params->pages, params->zipf_theta, &rng) != 0) {
+        return 1;
+    }
+    int window = params->pages / 4 < 256 ? (params->pages / 4 > 0 ? params->pages / 4 : 1) : 256;
+    uint32_t next_child = 2;
+    int status = 0;
+    size_t i = 0;
+    while (i < params->references && status == 0) {
+        if (workload_random(&rng) % 4096 == 0) {
+            int start = (int)(workload_random(&rng) % (uint64_t)(params->pages - window + 1));
+            for (int k = 0; k < window && i < params->references && status == 0; k++, i++) {
+                status = trace_append(trace, next_child, (uint32_t)(start + k + 1), 1);
+            }
+            next_child++;
+        } else {
+            status = workload_emit(trace, params, &rng, 1, zipf_next(&zipf, &rng));
+            i++;
+        }
+    }
+    zipf_free(&zipf);
+    return status;
+}
+
+// Registry of workload generators, run by the benchmark suite in this order
+const WorkloadGenerator workload_generators[] = {
+    {"zipf", "Zipfian hot set", generate_zipf},
+    {"loop", "looping scan over more pages than frames", generate_loop},
+    {"phases", "working set shifting through 8 phases", generate_phases},
+    {"interleave", "Zipfian processes interleaved in random quanta", generate_interleave},
+    {"fork", "parent hot set with fork-like copy bursts", generate_fork},
+};
+const int workload_generator_count = sizeof(workload_generators) / sizeof(workload_generators[0]);
+
+// Function to find a workload generator by name
+const WorkloadGenerator* find_workload(const char* name) {
+    for (int g = 0; g < workload_generator_count; g++) {
+        if (strcmp(workload_generators[g].name, name) == 0) {
+            return &workload_generators[g];
+        }
+    }
+    return NULL;
+}
+
+// Function to build a trace from a generator, checking the parameters first
+int generate_workload(const WorkloadGenerator* generator, const WorkloadParams* params, Trace* trace) {
+    if (params->references == 0 || params->pages <= 0 || params->processes <= 0 ||
+        params->write_ratio < 0 || params->write_ratio > 1 || params->zipf_theta <= 0 || params->zipf_theta == 1) {
+        printf("Invalid workload parameters. References, pages and processes must be greater than 0, "
+               "the write ratio in [0, 1] and theta positive and not 1.\n");
+        return 1;
+    }
+    trace->records = NULL;
+    trace->count = 0;
+    trace->capacity = 0;
+    if (generator->generate(trace, params) != 0) {
+        trace_free(trace);
+        return 1;
+    }
+    return 0;
+}
+
+// Function to write a trace in the format trace_load reads
+int trace_write(const Trace* trace, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        printf("Error: Could not open %s for writing.\n", path);
+        return 1;
+    }
+    for (size_t i = 0; i < trace->count; i++) {
+        const TraceRecord* record = &trace->records[i];
+        fprintf(file, "%u %u %c\n", record->process_id, record->page_number, record->write ? 'w' : 'r');
+    }
+    if (fclose(file) != 0) {
+        printf("Error: Could not write %s.\n", path);
+        return 1;
+    }
+    return 0;
+}
+
+// Function to create an empty page index sized for the given number of entries
+int page_index_init(PageIndex* index, size_t expected) {
+    size_t capacity = 16;
+    while (capacity < expected * 2) {
+        capacity *= 2; // Keep the load factor at or below one half
+    }
+    index->keys = (page_key*)malloc(capacity * sizeof(page_key));
+    index->values = (int*)malloc(capacity * sizeof(int));
+    if (index->keys == NULL || index->values == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        free(index->keys);
+        free(index->values);
+        index->keys = NULL;
+        index->values = NULL;
+        return 1;
+    }
+    for (size_t i = 0; i < capacity; i++) {
+        index->keys[i] = PAGE_KEY_NONE;
+    }
+    index->mask = capacity - 1;
+    index->count = 0;
+    return 0;
+}
+
+// Function to map a page key to its home slot
+static size_t page_index_slot(const PageIndex* index, page_key key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (size_t)key & index->mask;
+}
+
+// Function to look up the value stored for a page, or -1 if the page is absent
+int page_index_find(const PageIndex* index, page_key key) {
+    size_t slot = page_index_slot(index, key);
+    while (index->keys[slot] != PAGE_KEY_NONE) {
+        if (index->keys[slot] == key) {
+            return index->values[slot];
+        }
+        slot = (slot + 1) & index->mask;
+    }
+    return -1;
+}
+
+// Function to insert or update the value stored for a page
+void page_index_insert(PageIndex* index, page_key key, int value) {
+    size_t slot = page_index_slot(index, key);
+    while (index->keys[slot] != PAGE_KEY_NONE) {
+        if (index->keys[slot] == key) {
+            index->values[slot] = value;
+            return;
+        }
+        slot = (slot + 1) & index->mask;
+    }
+    index->keys[slot] = key;
+    index->values[slot] = value;
+    index->count++;
+}
+
+// Function to double the slot count of a page index, rehashing every stored page
+int page_index_grow(PageIndex* index) {
+    PageIndex grown;
+    if (page_index_init(&grown, (index->mask + 1)) != 0) {
+        return 1;
+    }
+    for (size_t i = 0; i <= index->mask; i++) {
+        if (index->keys[i] != PAGE_KEY_NONE) {
+            page_index_insert(&grown, index->keys[i], index->values[i]);
+        }
+    }
+    page_index_free(index);
+    *index = grown;
+    return 0;
+}
+
+// Function to remove a page, shifting later entries of its probe run back into the gap
+void page_index_remove(PageIndex* index, page_key key) {
+    size_t slot = page_index_slot(index, key);
+    while (index->keys[slot] != key) {
+        if (index->keys[slot] == PAGE_KEY_NONE) {
+            return;
+        }
+        slot = (slot + 1) & index->mask;
+    }
+    index->count--;
+
+    size_t hole = slot;
+    for (;;) {
+        slot = (slot + 1) & index->mask;
+        if (index->keys[slot] == PAGE_KEY_NONE) {
+            break;
+        }
+        // Move the entry back only if its home slot does not lie between the hole and its position
+        size_t home = page_index_slot(index, index->keys[slot]);
+        if (((slot - home) & index->mask) >= ((slot - hole) & index->mask)) {
+            index->keys[hole] = index->keys[slot];
+            index->values[hole] = index->values[slot];
+            hole = slot;
+        }
+    }
+    index->keys[hole] = PAGE_KEY_NONE;
+}
+
+// Function to empty a page index, keeping its slots
+void page_index_clear(PageIndex* index) {
+    for (size_t i = 0; i <= index->mask; i++) {
+        index->keys[i] = PAGE_KEY_NONE;
+    }
+    index->count = 0;
+}
+
+// Function to release a page index
+void page_index_free(PageIndex* index) {
+    free(index->keys);
+    free(index->values);
+    index->keys = NULL;
+    index->values = NULL;
+    index->count = 0;
+}
+
+// Function to create an empty recency list over nodes 0..capacity-1
+int recency_list_init(RecencyList* list, int capacity) {
+    list->prev = (int*)malloc(capacity * sizeof(int));
+    list->next = (int*)malloc(capacity * sizeof(int));
+    if (list->prev == NULL || list->next == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        free(list->prev);
+        free(list->next);
+        list->prev = NULL;
+        list->next = NULL;
+        return 1;
+    }
+    list->head = -1;
+    list->tail = -1;
+    list->size = 0;
+    return 0;
+}
+
+// Function to insert a node at the most-recently-used end of the list
+void recency_list_push_front(RecencyList* list, int node) {
+    list->prev[node] = -1;
+    list->next[node] = list->head;
+    if (list->head >= 0) {
+        list->prev[list->head] = node;
+    } else {
+        list->tail = node;
+    }
+    list->head = node;
+    list->size++;
+}
+
+// Function to unlink a node from the list
+void recency_list_remove(RecencyList* list, int node) {
+    if (list->prev[node] >= 0) {
+        list->next[list->prev[node]] = list->next[node];
+    } else {
+        list->head = list->next[node];
+    }
+    if (list->next[node] >= 0) {
+        list->prev[list->next[node]] = list->prev[node];
+    } else {
+        list->tail = list->prev[node];
+    }
+    list->size--;
+}
+
+// Function to release a recency list
+void recency_list_free(RecencyList* list) {
+    free(list->prev);
+    free(list->next);
+    list->prev = NULL;
+    list->next = NULL;
+}
+
+// Function to create an empty frame heap able to hold frames 0..capacity-1
+int frame_heap_init(FrameHeap* heap, int capacity) {
+    heap->heap = (int*)malloc(capacity * sizeof(int));
+    heap->position = (int*)malloc(capacity * sizeof(int));
+    heap->primary = (long long*)malloc(capacity * sizeof(long long));
+    heap->secondary = (long long*)malloc(capacity * sizeof(long long));
+    heap->size = 0;
+    if (heap->heap == NULL || heap->position == NULL || heap->primary == NULL || heap->secondary == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        frame_heap_free(heap);
+        return 1;
+    }
+    for (int i = 0; i < capacity; i++) {
+        heap->position[i] = -1;
+    }
+    return 0;
+}
+
+// Function to compare two frames by (primary, secondary) key
+static int frame_heap_less(const FrameHeap* heap, int a, int b) {
+    if (heap->primary[a] != heap->primary[b]) {
+        return heap->primary[a] < heap->primary[b];
+    }
+    return heap->secondary[a] < heap->secondary[b];
+}
+
+// Function to place a frame at a heap slot and record where it went
+static void frame_heap_place(FrameHeap* heap, int slot, int frame) {
+    heap->heap[slot] = frame;
+    heap->position[frame] = slot;
+}
+
+// Function to insert a frame or move it after its keys changed
+void frame_heap_update(FrameHeap* heap, int frame, long long primary, long long secondary) {
+    heap->primary[frame] = primary;
+    heap->secondary[frame] = secondary;
+    int slot = heap->position[frame];
+    if (slot < 0) {
+        slot = heap->size++;
+    }
+
+    // Sift up
+    while (slot > 0 && frame_heap_less(heap, frame, heap->heap[(slot - 1) / 2])) {
+        frame_heap_place(heap, slot, heap->heap[(slot - 1) / 2]);
+        slot = (slot - 1) / 2;
+    }
+    // Sift down
+    for (;;) {
+        int child = 2 * slot + 1;
+        if (child >= heap->size) {
+            break;
+        }
+        if (child + 1 < heap->size && frame_heap_less(heap, heap->heap[child + 1], heap->heap[child])) {
+            child++;
+        }
+        if (!frame_heap_less(heap, heap->heap[child], frame)) {
+            break;
+        }
+        frame_heap_place(heap, slot, heap->heap[child]);
+        slot = child;
+    }
+    frame_heap_place(heap, slot, frame);
+}
+
+// Function to release a frame heap
+void frame_heap_free(FrameHeap* heap) {
+    free(heap->heap);
+    free(heap->position);
+    free(heap->primary);
+    free(heap->secondary);
+    heap->heap = NULL;
+    heap->position = NULL;
+    heap->primary = NULL;
+    heap->secondary = NULL;
+}
+
+// Function to create an empty ghost list remembering up to capacity evicted pages
+int ghost_list_init(GhostList* ghost, int capacity) {
+    ghost->keys = (page_key*)malloc(capacity * sizeof(page_key));
+    ghost->free_slots = (int*)malloc(capacity * sizeof(int));
+    ghost->index.keys = NULL;
+    ghost->index.values = NULL;
+    ghost->order.prev = NULL;
+    ghost->order.next = NULL;
+    if (ghost->keys == NULL || ghost->free_slots == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        ghost_list_free(ghost);
+        return 1;
+    }
+    if (page_index_init(&ghost->index, capacity) != 0 || recency_list_init(&ghost->order, capacity) != 0) {
+        ghost_list_free(ghost);
+        return 1;
+    }
+    for (int i = 0; i < capacity; i++) {
+        ghost->free_slots[i] = capacity - 1 - i;
+    }
+    ghost->free_count = capacity;
+    return 0;
+}
+
+// Function to check whether a page is remembered by a ghost list
+int ghost_list_contains(const GhostList* ghost, page_key key) {
+    return page_index_find(&ghost->index, key) >= 0;
+}
+
+// Function to forget one page remembered by a ghost list
+void ghost_list_remove(GhostList* ghost, page_key key) {
+    int slot = page_index_find(&ghost->index, key);
+    if (slot >= 0) {
+        page_index_remove(&ghost->index, key);
+        recency_list_remove(&ghost->order, slot);
+        ghost->free_slots[ghost->free_count++] = slot;
+    }
+}
+
+// Function to forget the oldest page remembered by a ghost list
+void ghost_list_drop_oldest(GhostList* ghost) {
+    if (ghost->order.tail >= 0) {
+        ghost_list_remove(ghost, ghost->keys[ghost->order.tail]);
+    }
+}
+
+// Function to remember an evicted page, dropping the oldest entry when the list is full
+void ghost_list_push(GhostList* ghost, page_key key) {
+    if (ghost->free_count == 0) {
+        ghost_list_drop_oldest(ghost);
+    }
+    int slot = ghost->free_slots[--ghost->free_count];
+    ghost->keys[slot] = key;
+    page_index_insert(&ghost->index, key, slot);
+    recency_list_push_front(&ghost->order, slot);
+}
+
+// Function to release a ghost list
+void ghost_list_free(GhostList* ghost) {
+    free(ghost->keys);
+    free(ghost->free_slots);
+    ghost->keys = NULL;
+    ghost->free_slots = NULL;
+    page_index_free(&ghost->index);
+    recency_list_free(&ghost->order);
+}
+
+// Function to find a resident page: small tables are scanned with vector compares, larger ones use the page index
+static int policy_index_lookup(PolicyState* state, page_key page, size_t position) {
+    if (state->frame_count <= SCAN_LOOKUP_MAX_FRAMES) {
+        return frame_table_kernels->find_key(state->frames, state->frame_count, page);
+    }
+    return page_index_find(&state->index, page);
+}
+
+// FIFO: evict frames in the order they were filled
+typedef struct {
+    int hand;                // Next frame to evict
+} FifoState;
+
+static int fifo_init(PolicyState* state) {
+    FifoState* fifo = (FifoState*)calloc(1, sizeof(FifoState));
+    state->data = fifo;
+    return fifo == NULL;
+}
+
+static int fifo_victim(PolicyState* state, page_key page, size_t position) {
+    FifoState* fifo = (FifoState*)state->data;
+    int frame = fifo->hand;
+    fifo->hand = (fifo->hand + 1) % state->frame_count;
+    return frame;
+}
+
+static void fifo_touch(PolicyState* state, int frame, size_t position, int inserted) {
+}
+
+static void policy_free_data(PolicyState* state) {
+    free(state->data);
+    state->data = NULL;
+}
+
+// LRU: evict the tail of the recency list
+static int lru_init(PolicyState* state) {
+    RecencyList* recency = (RecencyList*)malloc(sizeof(RecencyList));
+    state->data = recency;
+    if (recency == NULL || recency_list_init(recency, state->frame_count) != 0) {
+        return 1;
+    }
+    return 0;
+}
+
+static int lru_victim(PolicyState* state, page_key page, size_t position) {
+    RecencyList* recency = (RecencyList*)state->data;
+    int frame = recency->tail;
+    recency_list_remove(recency, frame);
+    return frame;
+}
+
+static void lru_touch(PolicyState* state, int frame, size_t position, int inserted) {
+    RecencyList* recency = (RecencyList*)state->data;
+    if (!inserted) {
+        if (recency->head == frame) {
+            return;
+        }
+        recency_list_remove(recency, frame);
+    }
+    recency_list_push_front(recency, frame);
+}
+
+static void lru_destroy(PolicyState* state) {
+    if (state->data != NULL) {
+        recency_list_free((RecencyList*)state->data);
+    }
+    policy_free_data(state);
+}
+
+// LRU-SCAN: the original aging scan, kept as a baseline for benchmarks
+static int lru_scan_init(PolicyState* state) {
+    state->data = calloc(state->frame_count, sizeof(long long));
+    return state->data == NULL;
+}
+
+static int lru_scan_lookup(PolicyState* state, page_key page, size_t position) {
+    for (int j = 0; j < state->frame_count; j++) {
+        if (state->frames[j] == page) {
+            return j;
+        }
+    }
+    return -1;
+}
+
+static int lru_scan_victim(PolicyState* state, page_key page, size_t position) {
+    long long* use_count = (long long*)state->data;
+    int replace_index = 0;
+    for (int j = 1; j < state->frame_count; j++) {
+        if (use_count[j] > use_count[replace_index]) {
+            replace_index = j;
+        }
+    }
+    return replace_index;
+}
+
+static void lru_scan_touch(PolicyState* state, int frame, size_t position, int inserted) {
+    long long* use_count = (long long*)state->data;
+    // Age every other page
+    for (int j = 0; j < state->frame_count; j++) {
+        use_count[j]++;
+    }
+    use_count[frame] = 0;
+}
+
+// CLOCK: second-chance sweep over the reference bits kept in the frame table flags
+typedef struct {
+    int hand;                // Current clock hand position
+} ClockState;
+
+static int clock_init(PolicyState* state) {
+    state->data = calloc(1, sizeof(ClockState));
+    return state->data == NULL;
+}
+
+// Function to clear the reference bit of frames [start, end), the ones the hand sweeps past
+static void clock_clear_referenced(uint8_t* flags, int start, int end) {
+    for (int i = start; i < end; i++) {
+        flags[i] &= (uint8_t)~FRAME_REFERENCED;
+    }
+}
+
+static int clock_victim(PolicyState* state, page_key page, size_t position) {
+    ClockState* clock_state = (ClockState*)state->data;
+    uint8_t* flags = state->table->flags;
+    int hand = clock_state->hand;
+
+    // Vector search for the first unreferenced frame from the hand, wrapping once
+    int frame = frame_table_kernels->find_flag_clear(flags, hand, state->frame_count, FRAME_REFERENCED);
+    if (frame >= 0) {
+        clock_clear_referenced(flags, hand, frame);
+    } else {
+        clock_clear_referenced(flags, hand, state->frame_count);
+        frame = frame_table_kernels->find_flag_clear(flags, 0, hand, FRAME_REFERENCED);
+        if (frame >= 0) {
+            clock_clear_referenced(flags, 0, frame);
+        } else {
+            // Every frame was referenced: a full sweep cleared them all and stops at the hand
+            clock_clear_referenced(flags, 0, hand);
+            frame = hand;
+        }
+    }
+    clock_state->hand = (frame + 1) % state->frame_count;
+    return frame;
+}
+
+static void clock_touch(PolicyState* state, int frame, size_t position, int inserted) {
+    state->table->flags[frame] |= FRAME_REFERENCED;
+}
+
+// ARC: adaptive split between recency (T1) and frequency (T2), steered by ghost hits
+typedef struct {
+    RecencyList t1;          // Resident pages seen once recently
+    RecencyList t2;          // Resident pages seen at least twice recently
+    GhostList b1;            // Pages recently evicted from T1
+    GhostList b2;            // Pages recently evicted from T2
+    uint8_t* in_t2;          // 1 if the frame is linked into T2
+    int target_t1;           // Adaptive target size of T1 (p in the ARC paper)
+} ArcState;
+
+static int arc_init(PolicyState* state) {
+    ArcState* arc = (ArcState*)calloc(1, sizeof(ArcState));
+    state->data = arc;
+    if (arc == NULL) {
+        return 1;
+    }
+    arc->in_t2 = (uint8_t*)calloc(state->frame_count, sizeof(uint8_t));
+    if (arc->in_t2 == NULL || recency_list_init(&arc->t1, state->frame_count) != 0 ||
+        recency_list_init(&arc->t2, state->frame_count) != 0 || ghost_list_init(&arc->b1, state->frame_count) != 0 ||
+        ghost_list_init(&arc->b2, state->frame_count) != 0) {
+        return 1;
+    }
+    return 0;
+}
+
+// Function to run ARC's REPLACE step, moving the evicted page into the matching ghost list
+static int arc_replace(PolicyState* state, ArcState* arc, int requested_in_b2) {
+    int frame;
+    if (arc->t1.size > 0 && (arc->t2.size == 0 || arc->t1.size > arc->target_t1 ||
+                             (requested_in_b2 && arc->t1.size == arc->target_t1))) {
+        frame = arc->t1.tail;
+        recency_list_remove(&arc->t1, frame);
+        ghost_list_push(&arc->b1, state->frames[frame]);
+    } else {
+        frame = arc->t2.tail;
+        recency_list_remove(&arc->t2, frame);
+        ghost_list_push(&arc->b2, state->frames[frame]);
+    }
+    return frame;
+}
+
+static int arc_victim(PolicyState* state, page_key page, size_t position) {
+    ArcState* arc = (ArcState*)state->data;
+    int capacity = state->frame_count;
+
+    if (ghost_list_contains(&arc->b1, page)) {
+        int delta = arc->b2.order.size > arc->b1.order.size ? arc->b2.order.size / arc->b1.order.size : 1;
+        arc->target_t1 = arc->target_t1 + delta < capacity ? arc->target_t1 + delta : capacity;
+        return arc_replace(state, arc, 0);
+    }
+    if (ghost_list_contains(&arc->b2, page)) {
+        int delta = arc->b1.order.size > arc->b2.order.size ? arc->b1.order.size / arc->b2.order.size : 1;
+        arc->target_t1 = arc->target_t1 - delta > 0 ? arc->target_t1 - delta : 0;
+        return arc_replace(state, arc, 1);
+    }
+
+    // Cold miss: keep |T1| + |B1| <= c and the whole directory <= 2c
+    if (arc->t1.size + arc->b1.order.size == capacity) {
+        if (arc->t1.size < capacity) {
+            ghost_list_drop_oldest(&arc->b1);
+            return arc_replace(state, arc, 0);
+        }
+        int frame = arc->t1.tail;
+        recency_list_remove(&arc->t1, frame);
+        return frame;
+    }
+    if (arc->t1.size + arc->t2.size + arc->b1.order.size + arc->b2.order.size >= 2 * capacity) {
+        ghost_list_drop_oldest(&arc->b2);
+    }
+    return arc_replace(state, arc, 0);
+}
+
+static void arc_touch(PolicyState* state, int frame, size_t position, int inserted) {
+    ArcState* arc = (ArcState*)state->data;
+    page_key page = state->frames[frame];
+
+    if (!inserted) {
+        // Any hit promotes the page to the MRU end of T2
+        recency_list_remove(arc->in_t2[frame] ? &arc->t2 : &arc->t1, frame);
+    } else if (ghost_list_contains(&arc->b1, page)) {
+        ghost_list_remove(&arc->b1, page);
+    } else if (ghost_list_contains(&arc->b2, page)) {
+        ghost_list_remove(&arc->b2, page);
+    } else {
+        arc->in_t2[frame] = 0;
+        recency_list_push_front(&arc->t1, frame);
+        return;
+    }
+    arc->in_t2[frame] = 1;
+    recency_list_push_front(&arc->t2, frame);
+}
+
+static void arc_destroy(PolicyState* state) {
+    ArcState* arc = (ArcState*)state->data;
+    if (arc != NULL) {
+        recency_list_free(&arc->t1);
+        recency_list_free(&arc->t2);
+        ghost_list_free(&arc->b1);
+        ghost_list_free(&arc->b2);
+        free(arc->in_t2);
+    }
+    policy_free_data(state);
+}
+
+// 2Q: new pages wait in a FIFO (A1in); only pages re-referenced after leaving it enter the LRU (Am)
+typedef struct {
+    RecencyList a1_in;       // Resident pages on probation, FIFO order
+    RecencyList am;          // Resident hot pages, LRU order
+    GhostList a1_out;        // Pages recently evicted from A1in
+    uint8_t* in_am;          // 1 if the frame is linked into Am
+    int a1_in_limit;         // Kin: A1in size above which it gives up frames first
+} TwoQState;
+
+static int two_q_init(PolicyState* state) {
+    TwoQState* two_q = (TwoQState*)calloc(1, sizeof(TwoQState));
+    state->data = two_q;
+    if (two_q == NULL) {
+        return 1;
+    }
+    // Sizing recommended by Johnson and Shasha: Kin = c/4, Kout = c/2
+    two_q->a1_in_limit = state->frame_count / 4 > 0 ? state->frame_count / 4 : 1;
+    int a1_out_limit = state->frame_count / 2 > 0 ? state->frame_count / 2 : 1;
+    two_q->in_am = (uint8_t*)calloc(state->frame_count, sizeof(uint8_t));
+    if (two_q->in_am == NULL || recency_list_init(&two_q->a1_in, state->frame_count) != 0 ||
+        recency_list_init(&two_q->am, state->frame_count) != 0 || ghost_list_init(&two_q->a1_out, a1_out_limit) != 0) {
+        return 1;
+    }
+    return 0;
+}
+
+static int two_q_victim(PolicyState* state, page_key page, size_t position) {
+    TwoQState* two_q = (TwoQState*)state->data;
+    int frame;
+    if (two_q->a1_in.size > two_q->a1_in_limit || two_q->am.size == 0) {
+        frame = two_q->a1_in.tail;
+        recency_list_remove(&two_q->a1_in, frame);
+        ghost_list_push(&two_q->a1_out, state->frames[frame]);
+    } else {
+        frame = two_q->am.tail;
+        recency_list_remove(&two_q->am, frame);
+    }
+    return frame;
+}
+
+static void two_q_touch(PolicyState* state, int frame, size_t position, int inserted) {
+    TwoQState* two_q = (TwoQState*)state->data;
+    page_key page = state->frames[frame];
+
+    if (!inserted) {
+        // Hits in A1in leave its FIFO order alone
+        if (two_q->in_am[frame] && two_q->am.head != frame) {
+            recency_list_remove(&two_q->am, frame);
+            recency_list_push_front(&two_q->am, frame);
+        }
+    } else if (ghost_list_contains(&two_q->a1_out, page)) {
+        ghost_list_remove(&two_q->a1_out, page);
+        two_q->in_am[frame] = 1;
+        recency_list_push_front(&two_q->am, frame);
+    } else {
+        two_q->in_am[frame] = 0;
+        recency_list_push_front(&two_q->a1_in, frame);
+    }
+}
+
+static void two_q_destroy(PolicyState* state) {
+    TwoQState* two_q = (TwoQState*)state->data;
+    if (two_q != NULL) {
+        recency_list_free(&two_q->a1_in);
+        recency_list_free(&two_q->am);
+        ghost_list_free(&two_q->a1_out);
+        free(two_q->in_am);
+    }
+    policy_free_data(state);
+}
+
+// LFU: evict the least frequently used page, the least recently used one among ties
+typedef struct {
+    FrameHeap heap;          // Frames keyed by (use count, last use)
+} LfuState;
+
+static int lfu_init(PolicyState* state) {
+    LfuState* lfu = (LfuState*)calloc(1, sizeof(LfuState));
+    state->data = lfu;
+    return lfu == NULL || frame_heap_init(&lfu->heap, state->frame_count) != 0;
+}
+
+static int lfu_victim(PolicyState* state, page_key page, size_t position) {
+    LfuState* lfu = (LfuState*)state->data;
+    return lfu->heap.heap[0];
+}
+
+static void lfu_touch(PolicyState* state, int frame, size_t position, int inserted) {
+    LfuState* lfu = (LfuState*)state->data;
+    long long count = inserted ? 1 : lfu->heap.primary[frame] + 1;
+    frame_heap_update(&lfu->heap, frame, count, (long long)position);
+}
+
+static void lfu_destroy(PolicyState* state) {
+    if (state->data != NULL) {
+        frame_heap_free(&((LfuState*)state->data)->heap);
+    }
+    policy_free_data(state);
+}
+
+// OPT: Belady's offline optimum, evicting the page whose next use is furthest away
+typedef struct {
+    uint32_t* next_use;      // Position of the next reference to the same page, UINT32_MAX if none
+    FrameHeap heap;          // Frames keyed by negated next use, so the furthest is on top
+} OptState;
+
+static int opt_init(PolicyState* state) {
+    const Trace* trace = state->trace;
+    if (trace->count >= UINT32_MAX) {
+        printf("Error: OPT supports traces of up to %u references.\n", UINT32_MAX - 1);
+        return 1;
+    }
+    OptState* opt = (OptState*)calloc(1, sizeof(OptState));
+    state->data = opt;
+    if (opt == NULL) {
+        return 1;
+    }
+    opt->next_use = (uint32_t*)malloc((trace->count > 0 ? trace->count : 1) * sizeof(uint32_t));
+    if (opt->next_use == NULL || frame_heap_init(&opt->heap, state->frame_count) != 0) {
+        return 1;
+    }
+
+    // Build the next-use index in one backward pass; the map holds the latest position seen per page
+    PageIndex last_seen = {NULL, NULL, 0, 0};
+    if (page_index_init(&last_seen, 1024) != 0) {
+        return 1;
+    }
+    for (size_t i = trace->count; i-- > 0;) {
+        page_key page = trace_page_key(&trace->records[i], state->page_shift);
+        int next = page_index_find(&last_seen, page);
+        opt->next_use[i] = next >= 0 ? (uint32_t)next : UINT32_MAX;
+        if (last_seen.count * 2 >= last_seen.mask && next < 0) {
+            if (page_index_grow(&last_seen) != 0) {
+                page_index_free(&last_seen);
+                return 1;
+            }
+        }
+        page_index_insert(&last_seen, page, (int)i);
+    }
+    page_index_free(&last_seen);
+    return 0;
+}
+
+static int opt_victim(PolicyState* state, page_key page, size_t position) {
+    OptState* opt = (OptState*)state->data;
+    return opt->heap.heap[0];
+}
+
+static void opt_touch(PolicyState* state, int frame, size_t position, int inserted) {
+    OptState* opt = (OptState*)state->data;
+    frame_heap_update(&opt->heap, frame, -(long long)opt->next_use[position], 0);
+}
+
+static void opt_destroy(PolicyState* state) {
+    OptState* opt = (OptState*)state->data;
+    if (opt != NULL) {
+        free(opt->next_use);
+        frame_heap_free(&opt->heap);
+    }
+    policy_free_data(state);
+}
+
+const ReplacementPolicy replacement_policies[] = {
+    {"FIFO", fifo_init, policy_index_lookup, fifo_victim, fifo_touch, policy_free_data},
+    {"LRU", lru_init, policy_index_lookup, lru_victim, lru_touch, lru_destroy},
+    {"CLOCK", clock_init, policy_index_lookup, clock_victim, clock_touch, policy_free_data},
+    {"ARC", arc_init, policy_index_lookup, arc_victim, arc_touch, arc_destroy},
+    {"2Q", two_q_init, policy_index_lookup, two_q_victim, two_q_touch, two_q_destroy},
+    {"LFU", lfu_init, policy_index_lookup, lfu_victim, lfu_touch, lfu_destroy},
+    {"OPT", opt_init, policy_index_lookup, opt_victim, opt_touch, opt_destroy},
+};
+const int replacement_policy_count = sizeof(replacement_policies) / sizeof(replacement_policies[0]);
+
+// Benchmark baseline only; not part of "all"
+const ReplacementPolicy lru_scan_policy = {
+    "LRU-SCAN", lru_scan_init, lru_scan_lookup, lru_scan_victim, lru_scan_touch, policy_free_data
+};
+
+// Function to find a replacement policy by name
+const ReplacementPolicy* find_policy(const char* name) {
+    for (int i = 0; i < replacement_policy_count; i++) {
+        if (strcmp(replacement_policies[i].name, name) == 0) {
+            return &replacement_policies[i];
+        }
+    }
+    if (strcmp(lru_scan_policy.name, name) == 0) {
+        return &lru_scan_policy;
+    }
+    return NULL;
+}
+
+// Function to find the frame holding a key, scalar version
+static int find_key_scalar(const page_key* keys, int count, page_key key) {
+    for (int i = 0; i < count; i++) {
+        if (keys[i] == key) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Function to find the first frame in [start, end) whose flag is clear, scalar version
+static int find_flag_clear_scalar(const uint8_t* flags, int start, int end, uint8_t flag) {
+    for (int i = start; i < end; i++) {
+        if ((flags[i] & flag) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Function to count the frames owned by a process, scalar version
+static int count_owner_scalar(const int32_t* owners, int count, int32_t owner) {
+    int total = 0;
+    for (int i = 0; i < count; i++) {
+        total += owners[i] == owner;
+    }
+    return total;
+}
+
+#ifdef FRAME_TABLE_SIMD
+__attribute__((target("sse4.1")))
+static int find_key_sse41(const page_key* keys, int count, page_key key) {
+    __m128i wanted = _mm_set1_epi64x((long long)key);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i low = _mm_cmpeq_epi64(_mm_loadu_si128((const __m128i*)(keys + i)), wanted);
+        __m128i high = _mm_cmpeq_epi64(_mm_loadu_si128((const __m128i*)(keys + i + 2)), wanted);
+        int mask = _mm_movemask_pd(_mm_castsi128_pd(low)) | (_mm_movemask_pd(_mm_castsi128_pd(high)) << 2);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    int tail = find_key_scalar(keys + i, count - i, key);
+    return tail >= 0 ? i + tail : -1;
+}
+
+__attribute__((target("sse4.1")))
+static int find_flag_clear_sse41(const uint8_t* flags, int start, int end, uint8_t flag) {
+    __m128i bits = _mm_set1_epi8((char)flag);
+    __m128i zero = _mm_setzero_si128();
+    int i = start;
+    for (; i + 16 <= end; i += 16) {
+        __m128i clear = _mm_cmpeq_epi8(_mm_and_si128(_mm_loadu_si128((const __m128i*)(flags + i)), bits), zero);
+        int mask = _mm_movemask_epi8(clear);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return find_flag_clear_scalar(flags, i, end, flag);
+}
+
+__attribute__((target("sse4.1")))
+static int count_owner_sse41(const int32_t* owners, int count, int32_t owner) {
+    __m128i wanted = _mm_set1_epi32(owner);
+    int total = 0;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(owners + i)), wanted);
+        total += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(equal)));
+    }
+    return total + count_owner_scalar(owners + i, count - i, owner);
+}
+
+__attribute__((target("avx2")))
+static int find_key_avx2(const page_key* keys, int count, page_key key) {
+    __m256i wanted = _mm256_set1_epi64x((long long)key);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i low = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*)(keys + i)), wanted);
+        __m256i high = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*)(keys + i + 4)), wanted);
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(low)) | (_mm256_movemask_pd(_mm256_castsi256_pd(high)) << 4);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    int tail = find_key_scalar(keys + i, count - i, key);
+    return tail >= 0 ? i + tail : -1;
+}
+
+__attribute__((target("avx2")))
+static int find_flag_clear_avx2(const uint8_t* flags, int start, int end, uint8_t flag) {
+    __m256i bits = _mm256_set1_epi8((char)flag);
+    __m256i zero = _mm256_setzero_si256();
+    int i = start;
+    for (; i + 32 <= end; i += 32) {
+        __m256i clear = _mm256_cmpeq_epi8(_mm256_and_si256(_mm256_loadu_si256((const __m256i*)(flags + i)), bits), zero);
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(clear);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return find_flag_clear_scalar(flags, i, end, flag);
+}
+
+__attribute__((target("avx2")))
+static int count_owner_avx2(const int32_t* owners, int count, int32_t owner) {
+    __m256i wanted = _mm256_set1_epi32(owner);
+    int total = 0;
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i equal = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(owners + i)), wanted);
+        total += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(equal)));
+    }
+    return total + count_owner_scalar(owners + i, count - i, owner);
+}
+#endif
+
+const FrameTableKernels scalar_kernels = {"scalar", find_key_scalar, find_flag_clear_scalar, count_owner_scalar};
+#ifdef FRAME_TABLE_SIMD
+const FrameTableKernels sse41_kernels = {"sse4.1", find_key_sse41, find_flag_clear_sse41, count_owner_sse41};
+const FrameTableKernels avx2_kernels = {"avx2", find_key_avx2, find_flag_clear_avx2, count_owner_avx2};
+#endif
+
+// Function to pick the widest compare kernels the CPU supports
+void select_frame_table_kernels() {
+    frame_table_kernels = &scalar_kernels;
+#ifdef FRAME_TABLE_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        frame_table_kernels = &avx2_kernels;
+    } else if (__builtin_cpu_supports("sse4.1")) {
+        frame_table_kernels = &sse41_kernels;
+    }
+#endif
+}
+
+// Function to create a frame table with every frame empty
+int frame_table_init(FrameTable* table, int count) {
+    table->keys = (page_key*)malloc(count * sizeof(page_key));
+    table->owners = (int32_t*)malloc(count * sizeof(int32_t));
+    table->flags = (uint8_t*)malloc(count * sizeof(uint8_t));
+    table->count = count;
+    if (table->keys == NULL || table->owners == NULL || table->flags == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        frame_table_free(table);
+        return 1;
+    }
+    for (int i = 0; i < count; i++) {
+        table->keys[i] = PAGE_KEY_NONE; // Empty frame
+        table->owners[i] = -1;
+        table->flags[i] = 0;
+    }
+    return 0;
+}
+
+// Function to release a frame table
+void frame_table_free(FrameTable* table) {
+    free(table->keys);
+    free(table->owners);
+    free(table->flags);
+    table->keys = NULL;
+    table->owners = NULL;
+    table->flags = NULL;
+}
+
+// Device presets: fixed command latency, average seek plus half a rotation, transfer time per KB
+const DeviceModel device_models[] = {
+    {"nvme", 80000.0, 0.0, 330.0, 32},           // ~80 us 4K read, ~3 GB/s
+    {"ssd", 120000.0, 0.0, 1860.0, 32},          // SATA: ~120 us 4K read, ~550 MB/s, NCQ depth 32
+    {"hdd", 100000.0, 12660000.0, 6670.0, 1},    // 7200 rpm: 8.5 ms seek + 4.16 ms rotation, ~150 MB/s
+};
+const int device_model_count = sizeof(device_models) / sizeof(device_models[0]);
+
+// Function to find a device model by name
+const DeviceModel* find_device_model(const char* name) {
+    for (int i = 0; i < device_model_count; i++) {
+        if (strcmp(device_models[i].name, name) == 0) {
+            return &device_models[i];
+        }
+    }
+    return NULL;
+}
+
+// Function to fill in the default timing model: DRAM hits, 1 us fault trap, 4 KB pages on NVMe
+void timing_model_defaults(TimingModel* timing) {
+    timing->device = &device_models[0];
+    timing->dram_hit_ns = 100.0;
+    timing->fault_overhead_ns = 1000.0;
+    timing->page_kb = 4;
+    timing->queue_depth = timing->device->queue_depth;
+    timing->swap_file = NULL;
+    timing->compressed_pool_bytes = 0;
+    timing->compress_ns_per_kb = 2000.0;   // About 500 MB/s, typical of a fast LZ codec
+    timing->decompress_ns_per_kb = 500.0;  // About 2 GB/s
+}
+
+// Function to compute how long the device spends on one page transfer
+double device_service_ns(const TimingModel* timing) {
+    const DeviceModel* device = timing->device;
+    return device->command_ns + device->seek_ns + device->transfer_ns_per_kb * timing->page_kb;
+}
+
+// Function to compute the device time of one request covering several pages: the command and seek
+// are paid once, the transfer per page
+double device_batch_ns(const TimingModel* timing, int pages) {
+    const DeviceModel* device = timing->device;
+    return device->command_ns + device->seek_ns + device->transfer_ns_per_kb * timing->page_kb * pages;
+}
+
+// Function to create a device queue with every channel idle at time zero
+int device_queue_init(DeviceQueue* queue, const TimingModel* timing) {
+    queue->channels = timing->queue_depth > 0 ? timing->queue_depth : 1;
+    queue->free_at = (double*)calloc(queue->channels, sizeof(double));
+    queue->service_ns = device_service_ns(timing);
+    queue->reads = 0;
+    queue->writes = 0;
+    if (queue->free_at == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Function to submit one page transfer; returns the virtual time it completes. free_at is a
+// min-heap of channel idle times, so the request goes to the channel that frees up first.
+double device_queue_submit(DeviceQueue* queue, double now, int write) {
+    double start = queue->free_at[0] > now ? queue->free_at[0] : now;
+    double completion = start + queue->service_ns;
+
+    // Replace the root and sift it down
+    int slot = 0;
+    for (;;) {
+        int child = 2 * slot + 1;
+        if (child >= queue->channels) {
+            break;
+        }
+        if (child + 1 < queue->channels && queue->free_at[child + 1] < queue->free_at[child]) {
+            child++;
+        }
+        if (queue->free_at[child] >= completion) {
+            break;
+        }
+        queue->free_at[slot] = queue->free_at[child];
+        slot = child;
+    }
+    queue->free_at[slot] = completion;
+
+    if (write) {
+        queue->writes++;
+    } else {
+        queue->reads++;
+    }
+    return completion;
+}
+
+// Function to release a device queue
+void device_queue_free(DeviceQueue* queue) {
+    free(queue->free_at);
+    queue->free_at = NULL;
+}
+
+// Function to map a latency in nanoseconds to a histogram bucket (16 linear steps per power of two)
+static int latency_bucket(double latency_ns) {
+    uint64_t value = latency_ns > 0 ? (uint64_t)latency_ns : 0;
+    if (value < 16) {
+        return (int)value;
+    }
+    int exponent = 63 - __builtin_clzll(value);
+    return (exponent - 3) * 16 + (int)((value >> (exponent - 4)) & 15);
+}
+
+// Function to record one latency sample
+void latency_histogram_record(LatencyHistogram* histogram, double latency_ns) {
+    histogram->counts[latency_bucket(latency_ns)]++;
+    histogram->total++;
+    histogram->sum_ns += latency_ns;
+}
+
+// Function to read a percentile (0-100) from the histogram, in nanoseconds
+double latency_histogram_percentile(const LatencyHistogram* histogram, double percentile) {
+    long long rank = (long long)(histogram->total * percentile / 100.0);
+    long long seen = 0;
+    for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        seen += histogram->counts[bucket];
+        if (seen > rank) {
+            if (bucket < 16) {
+                return bucket;
+            }
+            int exponent = bucket / 16 + 3;
+            return (double)((16ULL + bucket % 16) << (exponent - 4));
+        }
+    }
+    return 0;
+}
+
+// Function to parse the timing options shared by the trace modes; returns the arguments consumed
+int parse_timing_option(int argc, char* argv[], int i, TimingModel* timing) {
+    if (i + 1 >= argc) {
+        return 0;
+    }
+    if (strcmp(argv[i], "--device") == 0) {
+        const DeviceModel* device = find_device_model(argv[i + 1]);
+        if (device == NULL) {
+            printf("Unknown device %s. Choose nvme, ssd or hdd.\n", argv[i + 1]);
+            return -1;
+        }
+        timing->device = device;
+        timing->queue_depth = device->queue_depth;
+        return 2;
+    }
+    if (strcmp(argv[i], "--queue-depth") == 0) {
+        timing->queue_depth = atoi(argv[i + 1]);
+        return 2;
+    }
+    if (strcmp(argv[i], "--page-kb") == 0) {
+        timing->page_kb = atoi(argv[i + 1]);
+        return 2;
+    }
+    if (strcmp(argv[i], "--dram-ns") == 0) {
+        timing->dram_hit_ns = atof(argv[i + 1]);
+        return 2;
+    }
+    if (strcmp(argv[i], "--zswap-mb") == 0) {
+        timing->compressed_pool_bytes = (size_t)(atof(argv[i + 1]) * 1024 * 1024);
+        return 2;
+    }
+    return 0;
+}
+
+// Function to open (or create) a swap file, using O_DIRECT when pages are whole 4 KB blocks so
+// reads and writes reach the device instead of the page cache
+int swap_file_open(SwapFile* swap, const char* path, size_t page_bytes) {
+    swap->fd = page_bytes % 4096 == 0 ? open(path, O_RDWR | O_CREAT | O_TRUNC | O_DIRECT, 0600) : -1;
+    swap->direct = swap->fd >= 0;
+    if (swap->fd < 0) {
+        swap->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600); // Small pages, or e.g. tmpfs, which rejects O_DIRECT
+    }
+    if (swap->fd < 0) {
+        printf("Error: Could not open swap file %s.\n", path);
+        return 1;
+    }
+    swap->page_bytes = page_bytes;
+    swap->cluster_capacity = SWAP_CLUSTER_PAGES;
+    swap->cluster_count = 0;
+    swap->cluster = NULL;
+    swap->cluster_slots = (int*)malloc(SWAP_CLUSTER_PAGES * sizeof(int));
+    swap->read_latency = (LatencyHistogram*)calloc(1, sizeof(LatencyHistogram));
+    swap->write_latency = (LatencyHistogram*)calloc(1, sizeof(LatencyHistogram));
+    swap->vectors = (struct iovec*)malloc(SWAP_CLUSTER_PAGES * sizeof(struct iovec));
+    swap->pages_read = 0;
+    swap->pages_written = 0;
+    swap->read_ns = 0;
+    swap->write_ns = 0;
+    if (posix_memalign((void**)&swap->cluster, 4096, (size_t)SWAP_CLUSTER_PAGES * page_bytes) != 0) {
+        swap->cluster = NULL;
+    }
+    if (swap->cluster == NULL || swap->cluster_slots == NULL || swap->read_latency == NULL ||
+        swap->write_latency == NULL || swap->vectors == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        swap_file_close(swap);
+        return 1;
+    }
+    return 0;
+}
+
+// Function to order pending cluster entries by swap slot
+static int compare_cluster_entries(const void* a, const void* b, void* slots) {
+    int slot_a = ((const int*)slots)[*(const int*)a];
+    int slot_b = ((const int*)slots)[*(const int*)b];
+    return (slot_a > slot_b) - (slot_a < slot_b);
+}
+
+// Function to write out the pending cluster; runs of adjacent slots go out as one pwritev each
+int swap_file_flush(SwapFile* swap) {
+    int order[SWAP_CLUSTER_PAGES];
+    for (int i = 0; i < swap->cluster_count; i++) {
+        order[i] = i;
+    }
+    qsort_r(order, swap->cluster_count, sizeof(int), compare_cluster_entries, swap->cluster_slots);
+
+    int status = 0;
+    for (int start = 0; start < swap->cluster_count;) {
+        int end = start + 1;
+        while (end < swap->cluster_count && swap->cluster_slots[order[end]] == swap->cluster_slots[order[end - 1]] + 1) {
+            end++;
+        }
+        for (int i = start; i < end; i++) {
+            swap->vectors[i - start].iov_base = swap->cluster + (size_t)order[i] * swap->page_bytes;
+            swap->vectors[i - start].iov_len = swap->page_bytes;
+        }
+        off_t offset = (off_t)swap->cluster_slots[order[start]] * swap->page_bytes;
+        size_t bytes = (size_t)(end - start) * swap->page_bytes;
+        struct timespec before, after;
+        clock_gettime(CLOCK_MONOTONIC, &before);
+        ssize_t written = pwritev(swap->fd, swap->vectors, end - start, offset);
+        clock_gettime(CLOCK_MONOTONIC, &after);
+        if (written != (ssize_t)bytes) {
+            printf("Error: Write to the swap file failed.\n");
+            status = 1;
+        }
+        double elapsed_ns = (after.tv_sec - before.tv_sec) * 1e9 + (after.tv_nsec - before.tv_nsec);
+        latency_histogram_record(swap->write_latency, elapsed_ns);
+        swap->write_ns += elapsed_ns;
+        swap->pages_written += end - start;
+        start = end;
+    }
+    swap->cluster_count = 0;
+    return status;
+}
+
+// Function to queue one page for writing to its slot; the cluster is flushed once it is full
+int swap_file_write(SwapFile* swap, int slot, const void* data) {
+    int entry = swap->cluster_count;
+    for (int i = 0; i < swap->cluster_count; i++) {
+        if (swap->cluster_slots[i] == slot) {
+            entry = i; // A slot released and reused before the flush keeps only its latest contents
+            break;
+        }
+    }
+    memcpy(swap->cluster + (size_t)entry * swap->page_bytes, data, swap->page_bytes);
+    swap->cluster_slots[entry] = slot;
+    if (entry == swap->cluster_count && ++swap->cluster_count == swap->cluster_capacity) {
+        return swap_file_flush(swap);
+    }
+    return 0;
+}
+
+// Function to copy a page still waiting in the write cluster out of it, dropping its write;
+// returns 1 if the slot was pending
+static int swap_file_take_pending(SwapFile* swap, int slot, unsigned char* data) {
+    for (int i = 0; i < swap->cluster_count; i++) {
+        if (swap->cluster_slots[i] == slot) {
+            memcpy(data, swap->cluster + (size_t)i * swap->page_bytes, swap->page_bytes);
+            int last = --swap->cluster_count;
+            if (i != last) {
+                memcpy(swap->cluster + (size_t)i * swap->page_bytes, swap->cluster + (size_t)last * swap->page_bytes, swap->page_bytes);
+                swap->cluster_slots[i] = swap->cluster_slots[last];
+            }
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Function to read up to SWAP_CLUSTER_PAGES pages back from their slots in as few operations as
+// possible: runs of adjacent slots are read with one preadv each. The caller releases the slots
+// afterwards, so pages still waiting in the write cluster are copied out and their writes dropped.
+int swap_file_read_batch(SwapFile* swap, const int* slots, unsigned char* const* pages, int count) {
+    int order[SWAP_CLUSTER_PAGES];
+    int pending = 0;
+    for (int i = 0; i < count; i++) {
+        if (!swap_file_take_pending(swap, slots[i], pages[i])) {
+            order[pending++] = i;
+        }
+    }
+    qsort_r(order, pending, sizeof(int), compare_cluster_entries, (void*)slots);
+
+    for (int start = 0; start < pending;) {
+        int end = start + 1;
+        while (end < pending && slots[order[end]] == slots[order[end - 1]] + 1) {
+            end++;
+        }
+        for (int i = start; i < end; i++) {
+            swap->vectors[i - start].iov_base = pages[order[i]];
+            swap->vectors[i - start].iov_len = swap->page_bytes;
+        }
+        size_t bytes = (size_t)(end - start) * swap->page_bytes;
+        struct timespec before, after;
+        clock_gettime(CLOCK_MONOTONIC, &before);
+        ssize_t read_bytes = preadv(swap->fd, swap->vectors, end - start, (off_t)slots[order[start]] * swap->page_bytes);
+        clock_gettime(CLOCK_MONOTONIC, &after);
+        if (read_bytes != (ssize_t)bytes) {
+            printf("Error: Read from the swap file failed.\n");
+            return 1;
+        }
+        double elapsed_ns = (after.tv_sec - before.tv_sec) * 1e9 + (after.tv_nsec - before.tv_nsec);
+        latency_histogram_record(swap->read_latency, elapsed_ns);
+        swap->read_ns += elapsed_ns;
+        swap->pages_read += end - start;
+        start = end;
+    }
+    return 0;
+}
+
+// Function to read one page back from its slot
+int swap_file_read(SwapFile* swap, int slot, void* data) {
+    unsigned char* page = (unsigned char*)data;
+    return swap_file_read_batch(swap, &slot, &page, 1);
+}
+
+// Function to print the measured swap I/O: operations, pages per write, latency and bandwidth
+void swap_file_report(const SwapFile* swap) {
+    const LatencyHistogram* reads = swap->read_latency;
+    const LatencyHistogram* writes = swap->write_latency;
+    printf("Swap file I/O (%s, %zu KB pages):\n", swap->direct ? "O_DIRECT" : "page cache", swap->page_bytes / 1024);
+    printf("  Reads:  %lld ops, mean %.2f us, p50 %.2f us, p99 %.2f us, %.2f MB/s\n",
+           reads->total, reads->total > 0 ? reads->sum_ns / reads->total / 1000.0 : 0,
+           latency_histogram_percentile(reads, 50.0) / 1000.0, latency_histogram_percentile(reads, 99.0) / 1000.0,
+           swap->read_ns > 0 ? swap->pages_read * swap->page_bytes / (swap->read_ns / 1e9) / 1e6 : 0);
+    printf("  Writes: %lld ops of %.1f pages on average, mean %.2f us, p50 %.2f us, p99 %.2f us, %.2f MB/s\n",
+           writes->total, writes->total > 0 ? (double)swap->pages_written / writes->total : 0,
+           writes->total > 0 ? writes->sum_ns / writes->total / 1000.0 : 0,
+           latency_histogram_percentile(writes, 50.0) / 1000.0, latency_histogram_percentile(writes, 99.0) / 1000.0,
+           swap->write_ns > 0 ? swap->pages_written * swap->page_bytes / (swap->write_ns / 1e9) / 1e6 : 0);
+}
+
+// Function to flush pending writes and release a swap file
+void swap_file_close(SwapFile* swap) {
+    if (swap->fd >= 0) {
+        if (swap->cluster != NULL && swap->cluster_count > 0) {
+            swap_file_flush(swap);
+        }
+        close(swap->fd);
+    }
+    free(swap->cluster);
+    free(swap->cluster_slots);
+    free(swap->read_latency);
+    free(swap->write_latency);
+    free(swap->vectors);
+    swap->fd = -1;
+    swap->cluster = NULL;
+    swap->cluster_slots = NULL;
+    swap->read_latency = NULL;
+    swap->write_latency = NULL;
+    swap->vectors = NULL;
+}
+
+// Function to fill a new page image with plausible contents: zeroed lines, small integers, repeated
+// lines and random bytes, all derived from the page key, with the key stamped at both ends
+void swap_page_fill(unsigned char* data, size_t page_bytes, page_key page) {
+    uint64_t state = page * 0x9e3779b97f4a7c15ULL + 1;
+    for (size_t line = 0; line + 64 <= page_bytes; line += 64) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        int kind = (int)(state % 100);
+        unsigned char* out = data + line;
+        if (kind < 40) {
+            memset(out, 0, 64);
+        } else if (kind < 70) {
+            for (int i = 0; i < 16; i++) {
+                uint32_t value = (uint32_t)((state >> (i % 8 * 8)) & 0xff);
+                memcpy(out + i * 4, &value, 4);
+            }
+        } else if (kind < 85 && line >= 64) {
+            memcpy(out, data + (state >> 32) % (line / 64) * 64, 64);
+        } else {
+            for (int i = 0; i < 64; i += 8) {
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+                memcpy(out + i, &state, 8);
+            }
+        }
+    }
+    memcpy(data, &page, sizeof(page));
+    memcpy(data + page_bytes - sizeof(page), &page, sizeof(page));
+}
+
+// Function to check the stamp of a page image brought back from swap; returns 1 if it is intact
+int swap_page_verify(const unsigned char* data, size_t page_bytes, page_key page) {
+    page_key head, tail;
+    memcpy(&head, data, sizeof(head));
+    memcpy(&tail, data + page_bytes - sizeof(tail), sizeof(tail));
+    return head == page && tail == page;
+}
+
+static inline uint32_t lz_read32(const unsigned char* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// Function to append an LZ length that did not fit its 4-bit token field
+static unsigned char* lz_write_length(unsigned char* op, const unsigned char* op_end, size_t length) {
+    for (; length >= 255; length -= 255) {
+        if (op >= op_end) {
+            return NULL;
+        }
+        *op++ = 255;
+    }
+    if (op >= op_end) {
+        return NULL;
+    }
+    *op++ = (unsigned char)length;
+    return op;
+}
+
+// Function to append one LZ sequence: a token, the literals, then (unless last) the match offset
+static unsigned char* lz_write_sequence(unsigned char* op, const unsigned char* op_end, const unsigned char* literals,
+                                        size_t literal_length, size_t offset, size_t match_length) {
+    if (op >= op_end) {
+        return NULL;
+    }
+    size_t match_code = match_length > 0 ? match_length - LZ_MIN_MATCH : 0;
+    unsigned char* token = op++;
+    *token = (unsigned char)((literal_length < 15 ? literal_length : 15) << 4 | (match_code < 15 ? match_code : 15));
+    if (literal_length >= 15 && (op = lz_write_length(op, op_end, literal_length - 15)) == NULL) {
+        return NULL;
+    }
+    if ((size_t)(op_end - op) < literal_length) {
+        return NULL;
+    }
+    memcpy(op, literals, literal_length);
+    op += literal_length;
+    if (match_length == 0) {
+        return op;
+    }
+    if (op_end - op < 2) {
+        return NULL;
+    }
+    *op++ = (unsigned char)(offset & 0xff);
+    *op++ = (unsigned char)(offset >> 8);
+    if (match_code >= 15) {
+        op = lz_write_length(op, op_end, match_code - 15);
+    }
+    return op;
+}
+
+// Function to compress a buffer with a byte-oriented LZ77 codec in the style of LZ4: a hash table
+// of 4-byte sequences finds matches up to 64 KB back. Returns the compressed size, or -1 if the
+// result would not fit in capacity bytes.
+int lz_compress(const unsigned char* source, size_t length, unsigned char* destination, size_t capacity) {
+    uint32_t table[1 << LZ_HASH_BITS]; // Position + 1 of the last sequence with each hash, 0 if none
+    memset(table, 0, sizeof(table));
+    unsigned char* op = destination;
+    const unsigned char* op_end = destination + capacity;
+    size_t anchor = 0;
+    size_t i = 0;
+    size_t misses = 0;       // Failed probes since the last match; long runs of them step faster
+    while (i + LZ_MIN_MATCH <= length) {
+        uint32_t sequence = lz_read32(source + i);
+        uint32_t hash = (sequence * 2654435761U) >> (32 - LZ_HASH_BITS);
+        size_t candidate = table[hash];
+        table[hash] = (uint32_t)(i + 1);
+        if (candidate == 0 || i - (candidate - 1) > 65535 || lz_read32(source + candidate - 1) != sequence) {
+            i += 1 + (misses++ >> 5);
+            continue;
+        }
+        misses = 0;
+        size_t match = candidate - 1;
+        size_t match_length = LZ_MIN_MATCH;
+        while (i + match_length < length && source[match + match_length] == source[i + match_length]) {
+            match_length++;
+        }
+        op = lz_write_sequence(op, op_end, source + anchor, i - anchor, i - match, match_length);
+        if (op == NULL) {
+            return -1;
+        }
+        i += match_length;
+        anchor = i;
+    }
+    op = lz_write_sequence(op, op_end, source + anchor, length - anchor, 0, 0);
+    return op != NULL ? (int)(op - destination) : -1;
+}
+
+// Function to decompress an lz_compress buffer; returns the decompressed size, or -1 if it is malformed
+int lz_decompress(const unsigned char* source, size_t length, unsigned char* destination, size_t capacity) {
+    const unsigned char* ip = source;
+    const unsigned char* ip_end = source + length;
+    unsigned char* op = destination;
+    unsigned char* op_end = destination + capacity;
+    while (ip < ip_end) {
+        unsigned token = *ip++;
+        size_t literal_length = token >> 4;
+        if (literal_length == 15) {
+            unsigned char extra;
+            do {
+                if (ip >= ip_end) {
+                    return -1;
+                }
+                extra = *ip++;
+                literal_length += extra;
+            } while (extra == 255);
+        }
+        if ((size_t)(ip_end - ip) < literal_length || (size_t)(op_end - op) < literal_length) {
+            return -1;
+        }
+        memcpy(op, ip, literal_length);
+        op += literal_length;
+        ip += literal_length;
+        if (ip == ip_end) {
+            break;
+        }
+
+        if (ip_end - ip < 2) {
+            return -1;
+        }
+        size_t offset = ip[0] | (size_t)ip[1] << 8;
+        ip += 2;
+        size_t match_length = (token & 15) + LZ_MIN_MATCH;
+        if ((token & 15) == 15) {
+            unsigned char extra;
+            do {
+                if (ip >= ip_end) {
+                    return -1;
+                }
+                extra = *ip++;
+                match_length += extra;
+            } while (extra == 255);
+        }
+        if (offset == 0 || offset > (size_t)(op - destination) || (size_t)(op_end - op) < match_length) {
+            return -1;
+        }
+        const unsigned char* match = op - offset;
+        if (offset >= match_length) {
+            memcpy(op, match, match_length);
+            op += match_length;
+        } else {
+            // Overlapping match: copy forward byte by byte so runs repeat
+            for (size_t k = 0; k < match_length; k++) {
+                *op++ = match[k];
+            }
+        }
+    }
+    return (int)(op - destination);
+}
+
+// Function to set up a compressed swap tier holding at most capacity_bytes of compressed pages;
+// pages it writes back go to backing when that is set
+int compressed_pool_init(CompressedPool* pool, size_t capacity_bytes, size_t page_bytes, SwapFile* backing) {
+    memset(pool, 0, sizeof(*pool));
+    pool->capacity_bytes = capacity_bytes;
+    pool->page_bytes = page_bytes;
+    pool->backing = backing;
+    pool->head = -1;
+    pool->tail = -1;
+    pool->free_entry = -1;
+    pool->compressed = (unsigned char*)malloc(page_bytes);
+    pool->page = (unsigned char*)malloc(page_bytes);
+    if (pool->compressed == NULL || pool->page == NULL || page_index_init(&pool->index, 1024) != 0) {
+        printf("Error: Memory allocation failed.\n");
+        compressed_pool_free(pool);
+        return 1;
+    }
+    return 0;
+}
+
+// Function to unlink an entry from the pool's LRU list and release its storage
+static void compressed_pool_remove(CompressedPool* pool, int entry) {
+    int prev = pool->prev[entry];
+    int next = pool->next[entry];
+    if (prev >= 0) {
+        pool->next[prev] = next;
+    } else {
+        pool->head = next;
+    }
+    if (next >= 0) {
+        pool->prev[next] = prev;
+    } else {
+        pool->tail = prev;
+    }
+    page_index_remove(&pool->index, (page_key)pool->slots[entry]);
+    pool->used_bytes -= pool->sizes[entry];
+    free(pool->data[entry]);
+    pool->data[entry] = NULL;
+    pool->next[entry] = pool->free_entry;
+    pool->free_entry = entry;
+    pool->count--;
+}
+
+// Function to write the least recently stored page back to disk to make room
+static int compressed_pool_writeback(CompressedPool* pool) {
+    int entry = pool->tail;
+    int status = 0;
+    if (pool->backing != NULL) {
+        if (lz_decompress(pool->data[entry], pool->sizes[entry], pool->page, pool->page_bytes) != (int)pool->page_bytes) {
+            printf("Error: A compressed page could not be decompressed.\n");
+            status = 1;
+        } else {
+            status = swap_file_write(pool->backing, pool->slots[entry], pool->page);
+        }
+    }
+    pool->stats.writebacks++;
+    compressed_pool_remove(pool, entry);
+    return status;
+}
+
+// Function to take a page on its way to swap slot `slot`. Returns 1 if the tier keeps it, 0 if it
+// does not compress below a page and must go to disk, or -1 on error.
+int compressed_pool_store(CompressedPool* pool, int slot, const unsigned char* data) {
+    struct timespec before, after;
+    clock_gettime(CLOCK_MONOTONIC, &before);
+    int size = lz_compress(data, pool->page_bytes, pool->compressed, pool->page_bytes - 1);
+    clock_gettime(CLOCK_MONOTONIC, &after);
+    pool->stats.compress_ns += (after.tv_sec - before.tv_sec) * 1e9 + (after.tv_nsec - before.tv_nsec);
+    if (size < 0 || (size_t)size > pool->capacity_bytes) {
+        pool->stats.rejects++;
+        return 0;
+    }
+    while (pool->used_bytes + size > pool->capacity_bytes) {
+        if (compressed_pool_writeback(pool) != 0) {
+            return -1;
+        }
+    }
+
+    int entry = pool->free_entry;
+    if (entry >= 0) {
+        pool->free_entry = pool->next[entry];
+    } else {
+        if (pool->entry_count == pool->entry_capacity) {
+            int capacity = pool->entry_capacity == 0 ? 1024 : pool->entry_capacity * 2;
+            unsigned char** data_grown = (unsigned char**)realloc(pool->data, capacity * sizeof(unsigned char*));
+            if (data_grown != NULL) {
+                pool->data = data_grown;
+            }
+            uint32_t* sizes_grown = (uint32_t*)realloc(pool->sizes, capacity * sizeof(uint32_t));
+            if (sizes_grown != NULL) {
+                pool->sizes = sizes_grown;
+            }
+            int* slots_grown = (int*)realloc(pool->slots, capacity * sizeof(int));
+            if (slots_grown != NULL) {
+                pool->slots = slots_grown;
+            }
+            int* prev_grown = (int*)realloc(pool->prev, capacity * sizeof(int));
+            if (prev_grown != NULL) {
+                pool->prev = prev_grown;
+            }
+            int* next_grown = (int*)realloc(pool->next, capacity * sizeof(int));
+            if (next_grown != NULL) {
+                pool->next = next_grown;
+            }
+            if (data_grown == NULL || sizes_grown == NULL || slots_grown == NULL || prev_grown == NULL || next_grown == NULL) {
+                printf("Error: Memory allocation failed.\n");
+                return -1;
+            }
+            pool->entry_capacity = capacity;
+        }
+        entry = pool->entry_count++;
+    }
+    pool->data[entry] = (unsigned char*)malloc(size > 0 ? size : 1);
+    if (pool->data[entry] == NULL ||
+        (pool->index.count * 2 >= pool->index.mask && page_index_grow(&pool->index) != 0)) {
+        printf("Error: Memory allocation failed.\n");
+        return -1;
+    }
+    memcpy(pool->data[entry], pool->compressed, size);
+    pool->sizes[entry] = (uint32_t)size;
+    pool->slots[entry] = slot;
+    page_index_insert(&pool->index, (page_key)slot, entry);
+
+    // The newest page goes to the head; writeback takes pages from the tail
+    pool->prev[entry] = -1;
+    pool->next[entry] = pool->head;
+    if (pool->head >= 0) {
+        pool->prev[pool->head] = entry;
+    } else {
+        pool->tail = entry;
+    }
+    pool->head = entry;
+    pool->used_bytes += size;
+    pool->count++;
+    pool->stats.stores++;
+    pool->stats.bytes_in += pool->page_bytes;
+    pool->stats.bytes_stored += size;
+    return 1;
+}
+
+// Function to bring the page of swap slot `slot` back from the tier. Returns 1 on a hit (the entry
+// is released, as the slot is about to be), 0 if the page is not in the tier, or -1 on error.
+int compressed_pool_load(CompressedPool* pool, int slot, unsigned char* data) {
+    int entry = page_index_find(&pool->index, (page_key)slot);
+    if (entry < 0) {
+        pool->stats.misses++;
+        return 0;
+    }
+    struct timespec before, after;
+    clock_gettime(CLOCK_MONOTONIC, &before);
+    int size = lz_decompress(pool->data[entry], pool->sizes[entry], data, pool->page_bytes);
+    clock_gettime(CLOCK_MONOTONIC, &after);
+    pool->stats.decompress_ns += (after.tv_sec - before.tv_sec) * 1e9 + (after.tv_nsec - before.tv_nsec);
+    compressed_pool_remove(pool, entry);
+    if (size != (int)pool->page_bytes) {
+        printf("Error: A compressed page could not be decompressed.\n");
+        return -1;
+    }
+    pool->stats.hits++;
+    return 1;
+}
+
+// Function to forget the page of a swap slot that is being released without a swap-in
+void compressed_pool_drop(CompressedPool* pool, int slot) {
+    int entry = page_index_find(&pool->index, (page_key)slot);
+    if (entry >= 0) {
+        compressed_pool_remove(pool, entry);
+    }
+}
+
+// Function to print the tier's compression ratio, hit rate, and CPU time against the disk time it saved
+void compressed_pool_report(const CompressedPoolStats* stats, double device_ns) {
+    long long loads = stats->hits + stats->misses;
+    double cpu_ms = (stats->compress_ns + stats->decompress_ns) / 1e6;
+    long long writes_avoided = stats->stores - stats->writebacks;
+    printf("Compressed swap tier:\n");
+    printf("  Stored %lld pages, rejected %lld, compression ratio %.2f\n", stats->stores, stats->rejects,
+           stats->bytes_stored > 0 ? (double)stats->bytes_in / stats->bytes_stored : 0);
+    printf("  Hit rate %.2f%% (%lld of %lld swap-ins), %lld pages written back to disk\n",
+           loads > 0 ? 100.0 * stats->hits / loads : 0, stats->hits, loads, stats->writebacks);
+    printf("  CPU %.3f ms (compress %.3f, decompress %.3f) vs %.3f ms of disk I/O avoided\n", cpu_ms,
+           stats->compress_ns / 1e6, stats->decompress_ns / 1e6, (stats->hits + writes_avoided) * device_ns / 1e6);
+}
+
+// Function to release every page the tier still holds
+void compressed_pool_free(CompressedPool* pool) {
+    for (int entry = pool->head; entry >= 0; entry = pool->next[entry]) {
+        free(pool->data[entry]);
+    }
+    free(pool->data);
+    free(pool->sizes);
+    free(pool->slots);
+    free(pool->prev);
+    free(pool->next);
+    free(pool->compressed);
+    free(pool->page);
+    page_index_free(&pool->index);
+    memset(pool, 0, sizeof(*pool));
+}
+
+// Function to set up real page data for a replay: one page image per frame, a swap slot map, and
+// the compressed tier when the timing model asks for one
+static int replay_swap_init(ReplaySwap* swap, const TimingModel* timing, int frame_count) {
+    swap->file = timing->swap_file;
+    swap->page_bytes = (size_t)timing->page_kb * 1024;
+    swap->mismatches = 0;
+    swap->frame_data = NULL;
+    swap->used_slots = NULL;
+    swap->slot_words = 0;
+    swap->cursor = 0;
+    swap->slots = (PageIndex){NULL, NULL, 0, 0};
+    memset(&swap->pool, 0, sizeof(swap->pool));
+    if (posix_memalign((void**)&swap->frame_data, 4096, (size_t)frame_count * swap->page_bytes) != 0) {
+        swap->frame_data = NULL;
+        printf("Error: Memory allocation failed.\n");
+        return 1;
+    }
+    if (timing->compressed_pool_bytes > 0 &&
+        compressed_pool_init(&swap->pool, timing->compressed_pool_bytes, swap->page_bytes, swap->file) != 0) {
+        return 1;
+    }
+    return page_index_init(&swap->slots, 1024);
+}
+
+// Function to take the first free swap slot at or after the cursor, wrapping once and growing the
+// bitmap when every slot is taken. Moving forward like this keeps consecutive victims in adjacent
+// slots, which is what lets the swap file coalesce them into one write.
+static int replay_swap_alloc_slot(ReplaySwap* swap) {
+    int total_slots = swap->slot_words * 64;
+    for (int pass = 0; pass < 2; pass++) {
+        int start = pass == 0 ? swap->cursor : 0;
+        int limit = pass == 0 ? total_slots : swap->cursor;
+        for (int slot = start; slot < limit;) {
+            uint64_t free_bits = ~swap->used_slots[slot / 64] & (~0ULL << (slot % 64));
+            if (free_bits != 0) {
+                int found = (slot / 64) * 64 + __builtin_ctzll(free_bits);
+                if (found < limit) {
+                    swap->used_slots[found / 64] |= 1ULL << (found % 64);
+                    swap->cursor = found + 1;
+                    return found;
+                }
+                break;
+            }
+            slot = (slot / 64 + 1) * 64;
+        }
+    }
+    int words = swap->slot_words == 0 ? 16 : swap->slot_words * 2;
+    uint64_t* grown = (uint64_t*)realloc(swap->used_slots, words * sizeof(uint64_t));
+    if (grown == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        return -1;
+    }
+    memset(grown + swap->slot_words, 0, (words - swap->slot_words) * sizeof(uint64_t));
+    swap->used_slots = grown;
+    swap->slot_words = words;
+    grown[total_slots / 64] |= 1;
+    swap->cursor = total_slots + 1;
+    return total_slots;
+}
+
+// Function to swap out a dirty victim's page image to a free slot, through the compressed tier when
+// there is one. Returns 1 if the tier kept the page, 0 if it went to disk, or -1 on error.
+static int replay_swap_out(ReplaySwap* swap, int frame, page_key page) {
+    int slot = replay_swap_alloc_slot(swap);
+    if (slot < 0) {
+        return -1;
+    }
+    if (swap->slots.count * 2 >= swap->slots.mask && page_index_grow(&swap->slots) != 0) {
+        return -1;
+    }
+    page_index_insert(&swap->slots, page, slot);
+    unsigned char* data = swap->frame_data + (size_t)frame * swap->page_bytes;
+    if (swap->pool.capacity_bytes > 0) {
+        int stored = compressed_pool_store(&swap->pool, slot, data);
+        if (stored != 0) {
+            return stored;
+        }
+    }
+    if (swap->file != NULL && swap_file_write(swap->file, slot, data) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+// Function to fill a frame with a faulted page. Returns 0 for a first touch (the page is filled
+// new), 1 when the compressed tier had it, 2 when it came back from disk, or -1 on error.
+static int replay_swap_in(ReplaySwap* swap, int frame, page_key page) {
+    unsigned char* data = swap->frame_data + (size_t)frame * swap->page_bytes;
+    int slot = page_index_find(&swap->slots, page);
+    if (slot < 0) {
+        swap_page_fill(data, swap->page_bytes, page);
+        return 0;
+    }
+    int source = 2;
+    if (swap->pool.capacity_bytes > 0) {
+        int hit = compressed_pool_load(&swap->pool, slot, data);
+        if (hit < 0) {
+            return -1;
+        }
+        source = hit ? 1 : 2;
+    }
+    if (source == 2) {
+        if (swap->file == NULL) {
+            swap_page_fill(data, swap->page_bytes, page); // Only the cost of the disk is modeled
+        } else if (swap_file_read(swap->file, slot, data) != 0) {
+            return -1;
+        }
+    }
+    if (!swap_page_verify(data, swap->page_bytes, page)) {
+        swap->mismatches++;
+    }
+    page_index_remove(&swap->slots, page);
+    swap->used_slots[slot / 64] &= ~(1ULL << (slot % 64));
+    return source;
+}
+
+// Function to release the page images, slot map and compressed tier of a replay
+static void replay_swap_free(ReplaySwap* swap) {
+    free(swap->frame_data);
+    free(swap->used_slots);
+    page_index_free(&swap->slots);
+    if (swap->pool.page != NULL) {
+        compressed_pool_free(&swap->pool);
+    }
+}
+
+// Function to find the slot of a process in the per-process ready-time array, adding it if new
+static int process_ready_slot(PageIndex* slots, double** ready, int* capacity, uint32_t process_id) {
+    int slot = page_index_find(slots, process_id);
+    if (slot >= 0) {
+        return slot;
+    }
+    slot = (int)slots->count;
+    if (slot == *capacity) {
+        int grown_capacity = *capacity * 2;
+        double* grown = (double*)realloc(*ready, grown_capacity * sizeof(double));
+        if (grown == NULL) {
+            printf("Error: Memory allocation failed.\n");
+            return -1;
+        }
+        *ready = grown;
+        *capacity = grown_capacity;
+    }
+    if (slots->count * 2 >= slots->mask && page_index_grow(slots) != 0) {
+        return -1;
+    }
+    (*ready)[slot] = 0;
+    page_index_insert(slots, process_id, slot);
+    return slot;
+}
+
+// Function to feed a trace through the replacement loop of one policy. With a timing model the
+// run is also timed on a virtual clock: references issue in trace order, a process waits for its
+// own previous reference to complete, and every fault reads its page through the device queue
+// (dirty victims are written back asynchronously first). Without one, only faults are counted.
+// A timing model with a swap file also moves real page images: victims are written to the file
+// and faults on swapped-out pages read them back.
+int replay_trace(const Trace* trace, int frame_count, const ReplacementPolicy* policy, const TimingModel* timing, int page_shift, ReplayResult* result) {
+    int previous_phase = probe_enter(PROBE_ALLOCATION);
+    FrameTable table;
+    if (frame_table_init(&table, frame_count) != 0) {
+        probe_leave(previous_phase);
+        return 1;
+    }
+    PolicyState state = {frame_count, table.keys, &table, {NULL, NULL, 0, 0}, trace, page_shift, NULL};
+    if (page_index_init(&state.index, frame_count) != 0 || policy->init(&state) != 0) {
+        printf("Error: Could not initialize the %s policy.\n", policy->name);
+        policy->destroy(&state);
+        page_index_free(&state.index);
+        frame_table_free(&table);
+        probe_leave(previous_phase);
+        return 1;
+    }
+
+    // Virtual clock state
+    DeviceQueue queue = {NULL, 0, 0, 0, 0};
+    PageIndex process_slots = {NULL, NULL, 0, 0};
+    int ready_capacity = 64;
+    double* ready = NULL;    // Virtual time each process's previous reference completes
+    LatencyHistogram* latencies = NULL;
+    double clock_ns = 0;     // Time the CPU is free to issue the next reference
+    double end_ns = 0;
+    int status = 0;
+    ReplaySwap swap;
+    int swap_data = timing != NULL && (timing->swap_file != NULL || timing->compressed_pool_bytes > 0);
+    memset(&swap, 0, sizeof(swap));
+    if (swap_data && replay_swap_init(&swap, timing, frame_count) != 0) {
+        status = 1;
+    }
+    if (timing != NULL) {
+        ready = (double*)malloc(ready_capacity * sizeof(double));
+        latencies = (LatencyHistogram*)calloc(1, sizeof(LatencyHistogram));
+        if (ready == NULL || latencies == NULL) {
+            printf("Error: Memory allocation failed.\n");
+            status = 1;
+        } else if (device_queue_init(&queue, timing) != 0 || page_index_init(&process_slots, 64) != 0) {
+            status = 1;
+        }
+    }
+
+    long long page_faults = 0;
+    long long writebacks = 0;
+    int used_frames = 0;
+    struct timespec start, end;
+    probe_enter(PROBE_REPLACEMENT);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (size_t i = 0; i < trace->count && status == 0; i++) {
+        const TraceRecord* record = &trace->records[i];
+        page_key page = trace_page_key(record, page_shift);
+        int ready_slot = 0;
+        double issue_ns = 0;
+        if (timing != NULL) {
+            ready_slot = process_ready_slot(&process_slots, &ready, &ready_capacity, record->process_id);
+            if (ready_slot < 0) {
+                status = 1;
+                break;
+            }
+            issue_ns = clock_ns > ready[ready_slot] ? clock_ns : ready[ready_slot];
+        }
+        double completion_ns = issue_ns + (timing != NULL ? timing->dram_hit_ns : 0);
+        double cpu_done_ns = completion_ns; // When the CPU can issue again; earlier than completion while a fault waits on the device
+
+        // Check if page is in memory
+        int frame_index = policy->lookup(&state, page, i);
+        if (frame_index >= 0) {
+            policy->touch(&state, frame_index, i, 0);
+        } else {
+            // Page fault occurs
+            page_faults++;
+            int dirty_victim = 0;
+            int swapped_out = 0;     // Where the dirty victim went: 1 compressed tier, 0 disk
+            int swapped_in = 0;      // Where the page came from: 1 compressed tier, otherwise disk
+            long long tier_writebacks = swap.pool.stats.writebacks;
+
+            if (used_frames < frame_count) {
+                frame_index = used_frames++;
+            } else {
+                frame_index = policy->victim(&state, page, i);
+                if (table.flags[frame_index] & FRAME_DIRTY) {
+                    writebacks++;
+                    dirty_victim = 1;
+                }
+                if (swap_data && dirty_victim) {
+                    int loop_phase = probe_enter(PROBE_SWAP);
+                    if ((swapped_out = replay_swap_out(&swap, frame_index, table.keys[frame_index])) < 0) {
+                        status = 1;
+                    }
+                    probe_leave(loop_phase);
+                }
+                page_index_remove(&state.index, table.keys[frame_index]);
+            }
+            if (swap_data) {
+                int loop_phase = probe_enter(PROBE_SWAP);
+                if ((swapped_in = replay_swap_in(&swap, frame_index, page)) < 0) {
+                    status = 1;
+                }
+                probe_leave(loop_phase);
+            }
+
+            if (timing != NULL) {
+                double submit_ns = issue_ns + timing->fault_overhead_ns;
+                if (swap.pool.capacity_bytes > 0 && dirty_victim) {
+                    submit_ns += timing->compress_ns_per_kb * timing->page_kb;
+                }
+                // Pages the tier wrote back to make room, and victims it did not take, go to the device
+                for (long long w = tier_writebacks; w < swap.pool.stats.writebacks; w++) {
+                    device_queue_submit(&queue, submit_ns, 1);
+                }
+                if (dirty_victim && swapped_out == 0) {
+                    device_queue_submit(&queue, submit_ns, 1);
+                }
+                if (swapped_in == 1) {
+                    completion_ns = submit_ns + timing->decompress_ns_per_kb * timing->page_kb + timing->dram_hit_ns;
+                    cpu_done_ns = completion_ns;
+                } else {
+                    completion_ns = device_queue_submit(&queue, submit_ns, 0) + timing->dram_hit_ns;
+                    cpu_done_ns = submit_ns;
+                }
+            }
+            table.keys[frame_index] = page;
+            table.owners[frame_index] = (int32_t)record->process_id;
+            // A page brought back from swap gives up its slot, so it must be written again on eviction
+            table.flags[frame_index] = swapped_in > 0 ? FRAME_DIRTY : 0;
+            page_index_insert(&state.index, page, frame_index);
+            policy->touch(&state, frame_index, i, 1);
+        }
+        if (record->write) {
+            table.flags[frame_index] |= FRAME_DIRTY;
+            if (swap_data) {
+                // Change one word of the page so written pages differ from their first image
+                uint64_t word = i;
+                size_t offset = 8 + (i * 8) % (swap.page_bytes - 16);
+                memcpy(swap.frame_data + (size_t)frame_index * swap.page_bytes + offset, &word, sizeof(word));
+            }
+        }
+
+        if (timing != NULL) {
+            // The CPU moves on after issuing; only this process waits for the completion
+            clock_ns = cpu_done_ns;
+            ready[ready_slot] = completion_ns;
+            if (completion_ns > end_ns) {
+                end_ns = completion_ns;
+            }
+            latency_histogram_record(latencies, completion_ns - issue_ns);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    probe_leave(previous_phase);
+    result->references = (long long)trace->count;
+    result->page_faults = page_faults;
+    result->writebacks = writebacks;
+    result->elapsed_us = (end.tv_sec - start.tv_sec) * 1000000.0 + (end.tv_nsec - start.tv_nsec) / 1000.0;
+    result->virtual_time_us = end_ns / 1000.0;
+    result->mean_latency_us = 0;
+    result->p50_latency_us = 0;
+    result->p99_latency_us = 0;
+    result->p999_latency_us = 0;
+    result->device_reads = queue.reads;
+    result->device_writes = queue.writes;
+    result->tier = swap.pool.stats;
+    if (swap.mismatches > 0) {
+        printf("Error: %lld pages came back from swap with the wrong contents.\n", swap.mismatches);
+        status = 1;
+    }
+    if (latencies != NULL && latencies->total > 0) {
+        result->mean_latency_us = latencies->sum_ns / latencies->total / 1000.0;
+        result->p50_latency_us = latency_histogram_percentile(latencies, 50.0) / 1000.0;
+        result->p99_latency_us = latency_histogram_percentile(latencies, 99.0) / 1000.0;
+        result->p999_latency_us = latency_histogram_percentile(latencies, 99.9) / 1000.0;
+    }
+
+    policy->destroy(&state);
+    page_index_free(&state.index);
+    frame_table_free(&table);
+    device_queue_free(&queue);
+    page_index_free(&process_slots);
+    replay_swap_free(&swap);
+    free(ready);
+    free(latencies);
+    return status;
+}
+
+// Function to run the non-interactive trace replay mode selected from the command line
+int run_trace_replay(int argc, char* argv[]) {
+    const char* trace_path = NULL;
+    const char* policy = "all";
+    int frame_count = DEFAULT_REPLAY_FRAMES;
+    const char* swap_path = NULL;
+    int probing = 0;
+    TimingModel timing = timing_model;
+
+    for (int i = 1; i < argc; i++) {
+        int consumed = parse_timing_option(argc, argv, i, &timing);
+        if (consumed < 0) {
+            return 1;
+        } else if (consumed > 0) {
+            i += consumed - 1;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--probe") == 0) {
+            probing = 1;
+        } else if (strcmp(argv[i], "--swap-file") == 0 && i + 1 < argc) {
+            swap_path = argv[++i];
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frame_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+            policy = argv[++i];
+        } else {
+            trace_path = NULL;
+            break;
+        }
+    }
+    if (trace_path == NULL) {
+        printf("Usage: %s --trace <file> [--frames N] [--policy NAME|all] [--device nvme|ssd|hdd]\n", argv[0]);
+        printf("           [--queue-depth N] [--page-kb N] [--dram-ns N] [--swap-file PATH] [--zswap-mb N] [--probe]\n");
+        printf("       %s --trace <file> --mrc <curve.csv> [--sample-rate R]\n", argv[0]);
+        printf("       %s --trace <file> --sweep <out.csv|out.json> [--policies A,B] [--frames-list N,M]\n", argv[0]);
+        printf("           [--page-kb-list N,M] [--threads N]\n");
+        printf("       %s --bench-suite <out.csv|out.json> [--frames N] [--refs N] [--pages N] [--seed N]\n", argv[0]);
+        printf("       %s --generate zipf|loop|phases|interleave|fork --trace-out <file> [--refs N] [--seed N]\n", argv[0]);
+        printf("       %s --concurrent [--threads-list 1,2,4,...] [--frames N] [--refs N] [--processes N]\n", argv[0]);
+        printf("       %s --bench-lru | --bench-lookup | --bench-alloc\n", argv[0]);
+        printf("Trace records are \"pid vpage [r|w]\", one per line.\n");
+        return 1;
+    }
+    if (frame_count <= 0) {
+        printf("Invalid frame count. Please enter a value greater than 0.\n");
+        return 1;
+    }
+    if (timing.page_kb <= 0 || timing.queue_depth <= 0) {
+        printf("Invalid timing model. Page size and queue depth must be greater than 0.\n");
+        return 1;
+    }
+    const ReplacementPolicy* selected = NULL;
+    if (strcmp(policy, "all") != 0 && (selected = find_policy(policy)) == NULL) {
+        printf("Unknown policy %s. Choose one of:", policy);
+        for (int p = 0; p < replacement_policy_count; p++) {
+            printf(" %s", replacement_policies[p].name);
+        }
+        printf(" LRU-SCAN all\n");
+        return 1;
+    }
+
+    Trace trace = {NULL, 0, 0};
+    struct timespec start, end;
+    if (probing) {
+        probe_init();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int previous_phase = probe_enter(PROBE_TRACE_LOAD);
+    int load_status = trace_load(trace_path, &trace);
+    probe_leave(previous_phase);
+    if (load_status != 0) {
+        probe_close();
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double load_ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0;
+    printf("Loaded %zu references from %s in %.2f ms\n", trace.count, trace_path, load_ms);
+    if (trace.count == 0) {
+        trace_free(&trace);
+        return 0;
+    }
+
+    // "all" runs every registered policy, which ends with OPT as the reference point
+    int run_count = selected != NULL ? 1 : replacement_policy_count;
+    ReplayResult results[sizeof(replacement_policies) / sizeof(replacement_policies[0])];
+    for (int p = 0; p < run_count; p++) {
+        const ReplacementPolicy* current = selected != NULL ? selected : &replacement_policies[p];
+        // With a swap file every policy starts from an empty file and reports its own I/O
+        SwapFile swap;
+        if (swap_path != NULL) {
+            if (swap_file_open(&swap, swap_path, (size_t)timing.page_kb * 1024) != 0) {
+                trace_free(&trace);
+                return 1;
+            }
+            timing.swap_file = &swap;
+        }
+        int status = replay_trace(&trace, frame_count, current, &timing, 0, &results[p]);
+        if (swap_path != NULL) {
+            swap_file_flush(&swap);
+            printf("%s: ", current->name);
+            swap_file_report(&swap);
+            swap_file_close(&swap);
+            timing.swap_file = NULL;
+        }
+        if (status != 0) {
+            trace_free(&trace);
+            return 1;
+        }
+    }
+    long long optimal_faults = selected == NULL ? results[run_count - 1].page_faults : -1;
+
+    printf("+----------+---------------+---------------+---------------+---------------+---------------+-----------+\n");
+    printf("| Policy   | Page Faults   | Fault Rate    | Writebacks    | Time (ms)     | Refs/s        | Over OPT  |\n");
+    printf("+----------+---------------+---------------+---------------+---------------+---------------+-----------+\n");
+    for (int p = 0; p < run_count; p++) {
+        const ReplacementPolicy* current = selected != NULL ? selected : &replacement_policies[p];
+        ReplayResult* result = &results[p];
+        double seconds = result->elapsed_us / 1000000.0;
+        printf("| %-8s | %13lld | %13.4f | %13lld | %13.2f | %13.0f |",
+               current->name, result->page_faults, (double)result->page_faults / result->references,
+               result->writebacks, result->elapsed_us / 1000.0,
+               seconds > 0 ? result->references / seconds : 0.0);
+        if (optimal_faults > 0) {
+            printf(" %8.2f%% |\n", 100.0 * (result->page_faults - optimal_faults) / optimal_faults);
+        } else {
+            printf(" %9s |\n", "n/a");
+        }
+    }
+    printf("+----------+---------------+---------------+---------------+---------------+---------------+-----------+\n");
+
+    printf("\nSimulated timing on %s (queue depth %d, %d KB pages, %.0f ns DRAM hit):\n",
+           timing.device->name, timing.queue_depth, timing.page_kb, timing.dram_hit_ns);
+    printf("+----------+---------------+---------------+---------------+---------------+---------------+\n");
+    printf("| Policy   | Virtual (ms)  | Mean (us)     | p50 (us)      | p99 (us)      | p99.9 (us)    |\n");
+    printf("+----------+---------------+---------------+---------------+---------------+---------------+\n");
+    for (int p = 0; p < run_count; p++) {
+        const ReplacementPolicy* current = selected != NULL ? selected : &replacement_policies[p];
+        ReplayResult* result = &results[p];
+        printf("| %-8s | %13.2f | %13.3f | %13.3f | %13.3f | %13.3f |\n",
+               current->name, result->virtual_time_us / 1000.0, result->mean_latency_us,
+               result->p50_latency_us, result->p99_latency_us, result->p999_latency_us);
+    }
+    printf("+----------+---------------+---------------+---------------+---------------+---------------+\n");
+
+    if (timing.compressed_pool_bytes > 0) {
+        // I/O avoided counts swap-ins served by the tier and stored pages never written back
+        double device_ns = device_service_ns(&timing);
+        printf("\nCompressed swap tier (%.1f MB):\n", timing.compressed_pool_bytes / (1024.0 * 1024.0));
+        printf("+----------+---------------+---------------+---------------+---------------+---------------+---------------+\n");
+        printf("| Policy   | Stored        | Rejected      | Ratio         | Hit Rate      | CPU (ms)      | I/O Saved (ms)|\n");
+        printf("+----------+---------------+---------------+---------------+---------------+---------------+---------------+\n");
+        for (int p = 0; p < run_count; p++) {
+            const ReplacementPolicy* current = selected != NULL ? selected : &replacement_policies[p];
+            const CompressedPoolStats* tier = &results[p].tier;
+            long long loads = tier->hits + tier->misses;
+            printf("| %-8s | %13lld | %13lld | %13.2f | %12.2f%% | %13.3f | %13.3f |\n",
+                   current->name, tier->stores, tier->rejects,
+                   tier->bytes_stored > 0 ? (double)tier->bytes_in / tier->bytes_stored : 0.0,
+                   loads > 0 ? 100.0 * tier->hits / loads : 0.0, (tier->compress_ns + tier->decompress_ns) / 1e6,
+                   (tier->hits + tier->stores - tier->writebacks) * device_ns / 1e6);
+        }
+        printf("+----------+---------------+---------------+---------------+---------------+---------------+---------------+\n");
+    }
+
+    probe_report();
+    probe_close();
+    trace_free(&trace);
+    return 0;
+}
+
+// Function to compare the constant-time LRU against the scanning LRU at growing frame counts
+int run_lru_benchmark() {
+    const int frame_counts[] = {1024, 65536, 1048576};
+    const long long scan_work = 400000000LL; // Frame visits allowed for each scanning run
+
+    printf("+------------+-----------------+-----------------+-----------+\n");
+    printf("| Frames     | LRU-SCAN refs/s | LRU refs/s      | Speedup   |\n");
+    printf("+------------+-----------------+-----------------+-----------+\n");
+    for (int c = 0; c < 3; c++) {
+        int frame_count = frame_counts[c];
+        Trace trace = {NULL, 0, 0};
+        Trace scan_trace = {NULL, 0, 0};
+        long long reference_count = 4000000LL > 8LL * frame_count ? 4000000LL : 8LL * frame_count;
+        long long scan_count = scan_work / frame_count;
+        uint64_t state = 0x9e3779b97f4a7c15ULL + (uint64_t)frame_count;
+
+        // Uniform references over twice as many pages as frames, so about half of them fault
+        for (long long i = 0; i < reference_count; i++) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            uint32_t page_number = (uint32_t)((state >> 33) % (2ULL * frame_count));
+            if (trace_append(&trace, 1, page_number, (state >> 20) & 1) != 0 ||
+                (i < scan_count && trace_append(&scan_trace, 1, page_number, (state >> 20) & 1) != 0)) {
+                trace_free(&trace);
+                trace_free(&scan_trace);
+                return 1;
+            }
+        }
+
+        ReplayResult scan_result, lru_result;
+        if (replay_trace(&scan_trace, frame_count, find_policy("LRU-SCAN"), NULL, 0, &scan_result) != 0 ||
+            replay_trace(&trace, frame_count, find_policy("LRU"), NULL, 0, &lru_result) != 0) {
+            trace_free(&trace);
+            trace_free(&scan_trace);
+            return 1;
+        }
+        double scan_rate = scan_result.references / (scan_result.elapsed_us / 1000000.0);
+        double lru_rate = lru_result.references / (lru_result.elapsed_us / 1000000.0);
+        printf("| %10d | %15.0f | %15.0f | %8.1fx |\n", frame_count, scan_rate, lru_rate, lru_rate / scan_rate);
+
+        trace_free(&trace);
+        trace_free(&scan_trace);
+    }
+    printf("+------------+-----------------+-----------------+-----------+\n");
+    return 0;
+}
+
+// Function to compare scalar, vector and hashed residency lookups at small and mid-size frame counts
+int run_lookup_benchmark() {
+    const int frame_counts[] = {8, 16, 32, 64, 128, 256, 1024, 4096};
+    const int lookups = 4000000;
+    const FrameTableKernels* vector_kernels = frame_table_kernels;
+
+    printf("Vector kernels: %s\n", vector_kernels->name);
+    printf("+------------+-----------------+-----------------+-----------------+\n");
+    printf("| Frames     | Scalar scan/s   | Vector scan/s   | Page index/s    |\n");
+    printf("+------------+-----------------+-----------------+-----------------+\n");
+    for (int c = 0; c < 8; c++) {
+        int frame_count = frame_counts[c];
+        FrameTable table;
+        PageIndex index;
+        page_key* probes = (page_key*)malloc(lookups * sizeof(page_key));
+        if (probes == NULL || frame_table_init(&table, frame_count) != 0) {
+            printf("Error: Memory allocation failed.\n");
+            free(probes);
+            return 1;
+        }
+        if (page_index_init(&index, frame_count) != 0) {
+            free(probes);
+            frame_table_free(&table);
+            return 1;
+        }
+
+        // Resident pages are the even page numbers; probes hit and miss about equally
+        uint64_t state = 0x2545f4914f6cdd1dULL + (uint64_t)frame_count;
+        for (int i = 0; i < frame_count; i++) {
+            table.keys[i] = make_page_key(1 + i % 8, 2 * i);
+            table.owners[i] = 1 + i % 8;
+            page_index_insert(&index, table.keys[i], i);
+        }
+        for (int i = 0; i < lookups; i++) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            int n = (int)((state >> 33) % (2ULL * frame_count));
+            probes[i] = make_page_key(1 + (n / 2) % 8, n % 2 == 0 ? n : 2 * frame_count + n);
+        }
+
+        double rates[3];
+        long long found = 0;
+        for (int variant = 0; variant < 3; variant++) {
+            struct timespec start, end;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (int i = 0; i < lookups; i++) {
+                if (variant == 0) {
+                    found += scalar_kernels.find_key(table.keys, frame_count, probes[i]);
+                } else if (variant == 1) {
+                    found += vector_kernels->find_key(table.keys, frame_count, probes[i]);
+                } else {
+                    found += page_index_find(&index, probes[i]);
+                }
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1000000000.0;
+            rates[variant] = lookups / seconds;
+        }
+        printf("| %10d | %15.0f | %15.0f | %15.0f |\n", frame_count, rates[0], rates[1], rates[2]);
+        if (found == 42) {
+            printf("\n"); // Keeps the lookups from being optimized away
+        }
+
+        free(probes);
+        frame_table_free(&table);
+        page_index_free(&index);
+    }
+    printf("+------------+-----------------+-----------------+-----------------+\n");
+    return 0;
+}
+
+// Function to compute the LRU miss-ratio curve of a trace in one pass (Mattson stack distances).
+// A Fenwick tree over reference positions marks the latest position of every page, so the stack
+// distance of a reuse is the number of marks after the page's previous position. With a sample
+// rate below 1, only pages whose hash falls under the threshold are tracked (SHARDS) and their
+// distances are scaled by 1 / rate.
+int compute_miss_ratio_curve(const Trace* trace, double sample_rate, MissRatioCurve* curve) {
+    const uint64_t modulus = 1ULL << 24;
+    uint64_t threshold = (uint64_t)(sample_rate * modulus);
+    PageIndex last_seen = {NULL, NULL, 0, 0};
+    int* fenwick = (int*)calloc(trace->count + 1, sizeof(int));
+    size_t histogram_size = 1024;
+    long long* histogram = (long long*)calloc(histogram_size, sizeof(long long));
+
+    curve->misses = NULL;
+    curve->max_frames = 0;
+    curve->references = 0;
+    curve->cold_misses = 0;
+    curve->distinct_pages = 0;
+    if (fenwick == NULL || histogram == NULL || page_index_init(&last_seen, 1024) != 0) {
+        printf("Error: Memory allocation failed.\n");
+        free(fenwick);
+        free(histogram);
+        page_index_free(&last_seen);
+        return 1;
+    }
+
+    size_t sampled = 0;          // Positions handed out so far; the Fenwick tree is indexed by them
+    size_t max_distance = 0;
+    for (size_t i = 0; i < trace->count; i++) {
+        page_key page = make_page_key(trace->records[i].process_id, trace->records[i].page_number);
+        uint64_t hash = page * 0x9e3779b97f4a7c15ULL;
+        if ((hash >> 40) % modulus >= threshold) {
+            continue;
+        }
+        size_t position = ++sampled;
+        int previous = page_index_find(&last_seen, page);
+
+        if (previous < 0) {
+            curve->cold_misses++;
+            if (last_seen.count * 2 >= last_seen.mask && page_index_grow(&last_seen) != 0) {
+                free(fenwick);
+                free(histogram);
+                page_index_free(&last_seen);
+                return 1;
+            }
+        } else {
+            // Distinct pages touched since the previous reference, counting this page itself
+            long long distance = 1;
+            for (size_t j = position - 1; j > 0; j -= j & (~j + 1)) {
+                distance += fenwick[j];
+            }
+            for (size_t j = (size_t)previous; j > 0; j -= j & (~j + 1)) {
+                distance -= fenwick[j];
+            }
+            for (size_t j = (size_t)previous; j <= trace->count; j += j & (~j + 1)) {
+                fenwick[j]--;
+            }
+
+            size_t scaled = (size_t)(distance / sample_rate + 0.5);
+            if (scaled >= histogram_size) {
+                size_t grown_size = histogram_size;
+                while (grown_size <= scaled) {
+                    grown_size *= 2;
+                }
+                long long* grown = (long long*)realloc(histogram, grown_size * sizeof(long long));
+                if (grown == NULL) {
+                    printf("Error: Memory allocation failed.\n");
+                    free(fenwick);
+                    free(histogram);
+                    page_index_free(&last_seen);
+                    return 1;
+                }
+                memset(grown + histogram_size, 0, (grown_size - histogram_size) * sizeof(long long));
+                histogram = grown;
+                histogram_size = grown_size;
+            }
+            histogram[scaled]++;
+            if (scaled > max_distance) {
+                max_distance = scaled;
+            }
+        }
+        for (size_t j = position; j <= trace->count; j += j & (~j + 1)) {
+            fenwick[j]++;
+        }
+        page_index_insert(&last_seen, page, (int)position);
+    }
+
+    // SHARDS-adj: credit the gap between the expected and actual sample size to the smallest
+    // distance, which removes most of the bias left by a few hot pages falling in or out of the sample
+    long long expected = (long long)(trace->count * sample_rate + 0.5);
+    if (sample_rate < 1.0 && expected > 0) {
+        histogram[1] += expected - (long long)sampled;
+        sampled = (size_t)expected;
+    }
+
+    // A reference with stack distance d misses in every cache smaller than d frames
+    curve->references = (long long)sampled;
+    curve->distinct_pages = (long long)(last_seen.count / sample_rate + 0.5);
+    curve->max_frames = max_distance > 0 ? (int)max_distance : 1;
+    curve->misses = (long long*)malloc((curve->max_frames + 1) * sizeof(long long));
+    if (curve->misses == NULL) {
+        printf("Error: Memory allocation failed.\n");
+    } else {
+        long long misses = (long long)sampled;
+        curve->misses[0] = misses;
+        for (int frames = 1; frames <= curve->max_frames; frames++) {
+            misses -= histogram[frames];
+            curve->misses[frames] = misses;
+        }
+    }
+
+    free(fenwick);
+    free(histogram);
+    page_index_free(&last_seen);
+    return curve->misses == NULL;
+}
+
+// Function to write a miss-ratio curve as "frames,miss_ratio" rows
+int write_miss_ratio_curve(const MissRatioCurve* curve, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        printf("Error: Could not open %s for writing\n", path);
+        return 1;
+    }
+    fprintf(file, "frames,miss_ratio\n");
+    for (int frames = 1; frames <= curve->max_frames; frames++) {
+        fprintf(file, "%d,%.6f\n", frames, (double)curve->misses[frames] / curve->references);
+    }
+    fclose(file);
+    return 0;
+}
+
+// Function to run the single-pass miss-ratio curve mode selected from the command line
+int run_miss_ratio_curve(int argc, char* argv[]) {
+    const char* trace_path = NULL;
+    const char* output_path = NULL;
+    double sample_rate = 1.0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--mrc") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (strcmp(argv[i], "--sample-rate") == 0 && i + 1 < argc) {
+            sample_rate = atof(argv[++i]);
+        } else {
+            trace_path = NULL;
+            break;
+        }
+    }
+    if (trace_path == NULL || output_path == NULL) {
+        printf("Usage: %s --trace <file> --mrc <curve.csv> [--sample-rate R]\n", argv[0]);
+        return 1;
+    }
+    if (sample_rate <= 0 || sample_rate > 1) {
+        printf("Invalid sample rate. Please enter a value in (0, 1].\n");
+        return 1;
+    }
+
+    Trace trace = {NULL, 0, 0};
+    if (trace_load(trace_path, &trace) != 0) {
+        return 1;
+    }
+    if (trace.count >= INT32_MAX) {
+        printf("Error: Miss-ratio curves support traces of up to %d references.\n", INT32_MAX - 1);
+        trace_free(&trace);
+        return 1;
+    }
+
+    MissRatioCurve curve;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int status = compute_miss_ratio_curve(&trace, sample_rate, &curve);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (status == 0) {
+        double elapsed_ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0;
+        printf("Sampled %lld of %zu references (rate %.4f), about %lld distinct pages\n",
+               curve.references, trace.count, sample_rate, curve.distinct_pages);
+        printf("Miss-ratio curve for 1..%d frames computed in %.2f ms\n", curve.max_frames, elapsed_ms);
+        status = write_miss_ratio_curve(&curve, output_path);
+        if (status == 0) {
+            printf("Curve written to %s\n", output_path);
+        }
+        free(curve.misses);
+    }
+    trace_free(&trace);
+    return status;
+}
+
+// Function to parse a comma-separated list of positive integers; returns the count or -1
+static int parse_int_list(const char* text, int* values, int max_values) {
+    int count = 0;
+    const char* cursor = text;
+    while (*cursor != '\0') {
+        char* end;
+        long value = strtol(cursor, &end, 10);
+        if (end == cursor || value <= 0 || value > INT32_MAX || count == max_values || (*end != ',' && *end != '\0')) {
+            return -1;
+        }
+        values[count++] = (int)value;
+        cursor = *end == ',' ? end + 1 : end;
+    }
+    return count;
+}
+
+// Function run by each sweep worker: claim the next cell until none are left
+static void* sweep_worker(void* arg) {
+    SweepQueue* queue = (SweepQueue*)arg;
+    for (;;) {
+        int index = __atomic_fetch_add(&queue->next_cell, 1, __ATOMIC_RELAXED);
+        if (index >= queue->cell_count) {
+            return NULL;
+        }
+        SweepCell* cell = &queue->cells[index];
+        TimingModel timing = *queue->timing;
+        timing.page_kb = cell->page_kb;
+        int page_shift = __builtin_ctz((unsigned)(cell->page_kb / TRACE_PAGE_KB));
+        cell->status = replay_trace(queue->trace, cell->frame_count, cell->policy, &timing, page_shift, &cell->result);
+    }
+}
+
+// Function to write every sweep cell as CSV rows or, for a .json path, a JSON array
+static int write_sweep_results(const SweepQueue* queue, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        printf("Error: Could not open %s for writing.\n", path);
+        return 1;
+    }
+    size_t length = strlen(path);
+    int json = length >= 5 && strcmp(path + length - 5, ".json") == 0;
+    if (json) {
+        fprintf(file, "[\n");
+    } else {
+        fprintf(file, "policy,frames,page_kb,references,page_faults,fault_rate,writebacks,"
+                      "virtual_ms,mean_us,p50_us,p99_us,p999_us,elapsed_ms\n");
+    }
+    for (int c = 0; c < queue->cell_count; c++) {
+        const SweepCell* cell = &queue->cells[c];
+        const ReplayResult* result = &cell->result;
+        double fault_rate = result->references > 0 ? (double)result->page_faults / result->references : 0;
+        if (json) {
+            fprintf(file, "  {\"policy\": \"%s\", \"frames\": %d, \"page_kb\": %d, \"references\": %lld, "
+                          "\"page_faults\": %lld, \"fault_rate\": %.6f, \"writebacks\": %lld, \"virtual_ms\": %.3f, "
+                          "\"mean_us\": %.3f, \"p50_us\": %.3f, \"p99_us\": %.3f, \"p999_us\": %.3f, \"elapsed_ms\": %.3f}%s\n",
+                    cell->policy->name, cell->frame_count, cell->page_kb, result->references, result->page_faults,
+                    fault_rate, result->writebacks, result->virtual_time_us / 1000.0, result->mean_latency_us,
+                    result->p50_latency_us, result->p99_latency_us, result->p999_latency_us,
+                    result->elapsed_us / 1000.0, c + 1 < queue->cell_count ? "," : "");
+        } else {
+            fprintf(file, "%s,%d,%d,%lld,%lld,%.6f,%lld,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+                    cell->policy->name, cell->frame_count, cell->page_kb, result->references, result->page_faults,
+                    fault_rate, result->writebacks, result->virtual_time_us / 1000.0, result->mean_latency_us,
+                    result->p50_latency_us, result->p99_latency_us, result->p999_latency_us, result->elapsed_us / 1000.0);
+        }
+    }
+    if (json) {
+        fprintf(file, "]\n");
+    }
+    if (fclose(file) != 0) {
+        printf("Error: Could not write %s.\n", path);
+        return 1;
+    }
+    return 0;
+}
+
+// Function to replay one trace over a grid of policies, frame counts and page sizes on a worker pool
+int run_sweep(int argc, char* argv[]) {
+    const char* trace_path = NULL;
+    const char* output_path = NULL;
+    const char* policy_list = "all";
+    int frame_counts[MAX_SWEEP_VALUES] = {DEFAULT_REPLAY_FRAMES};
+    int page_sizes[MAX_SWEEP_VALUES] = {TRACE_PAGE_KB};
+    int frame_value_count = 1;
+    int page_value_count = 1;
+    long thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+    TimingModel timing = timing_model;
+
+    for (int i = 1; i < argc; i++) {
+        int consumed = parse_timing_option(argc, argv, i, &timing);
+        if (consumed < 0) {
+            return 1;
+        } else if (consumed > 0) {
+            i += consumed - 1;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--sweep") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (strcmp(argv[i], "--policies") == 0 && i + 1 < argc) {
+            policy_list = argv[++i];
+        } else if (strcmp(argv[i], "--frames-list") == 0 && i + 1 < argc) {
+            frame_value_count = parse_int_list(argv[++i], frame_counts, MAX_SWEEP_VALUES);
+        } else if (strcmp(argv[i], "--page-kb-list") == 0 && i + 1 < argc) {
+            page_value_count = parse_int_list(argv[++i], page_sizes, MAX_SWEEP_VALUES);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            thread_count = atol(argv[++i]);
+        } else {
+            trace_path = NULL;
+            break;
+        }
+    }
+    if (trace_path == NULL || output_path == NULL) {
+        printf("Usage: %s --trace <file> --sweep <out.csv|out.json> [--policies A,B|all] [--frames-list N,M]\n", argv[0]);
+        printf("           [--page-kb-list N,M] [--threads N] [--device nvme|ssd|hdd] [--queue-depth N] [--dram-ns N]\n");
+        return 1;
+    }
+    if (frame_value_count <= 0 || page_value_count <= 0) {
+        printf("Invalid list. Give up to %d comma-separated values greater than 0.\n", MAX_SWEEP_VALUES);
+        return 1;
+    }
+    for (int p = 0; p < page_value_count; p++) {
+        int multiple = page_sizes[p] / TRACE_PAGE_KB;
+        if (page_sizes[p] % TRACE_PAGE_KB != 0 || (multiple & (multiple - 1)) != 0) {
+            printf("Invalid page size %d KB. Use %d KB times a power of two.\n", page_sizes[p], TRACE_PAGE_KB);
+            return 1;
+        }
+    }
+    if (thread_count <= 0 || timing.queue_depth <= 0) {
+        printf("Invalid thread count or queue depth. Please enter values greater than 0.\n");
+        return 1;
+    }
+
+    // Resolve the policy axis; "all" means every registered policy
+    const ReplacementPolicy* policies[MAX_SWEEP_VALUES];
+    int policy_value_count = 0;
+    if (strcmp(policy_list, "all") == 0) {
+        for (int p = 0; p < replacement_policy_count; p++) {
+            policies[policy_value_count++] = &replacement_policies[p];
+        }
+    } else {
+        char names[256];
+        snprintf(names, sizeof(names), "%s", policy_list);
+        for (char* name = strtok(names, ","); name != NULL; name = strtok(NULL, ",")) {
+            const ReplacementPolicy* policy = find_policy(name);
+            if (policy == NULL || policy_value_count == MAX_SWEEP_VALUES) {
+                printf("Unknown policy %s.\n", name);
+                return 1;
+            }
+            policies[policy_value_count++] = policy;
+        }
+    }
+
+    Trace trace = {NULL, 0, 0};
+    if (trace_load(trace_path, &trace) != 0) {
+        return 1;
+    }
+
+    int cell_count = policy_value_count * frame_value_count * page_value_count;
+    SweepCell* cells = (SweepCell*)calloc(cell_count, sizeof(SweepCell));
+    if (cells == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        trace_free(&trace);
+        return 1;
+    }
+    int c = 0;
+    for (int p = 0; p < policy_value_count; p++) {
+        for (int f = 0; f < frame_value_count; f++) {
+            for (int s = 0; s < page_value_count; s++) {
+                cells[c].policy = policies[p];
+                cells[c].frame_count = frame_counts[f];
+                cells[c].page_kb = page_sizes[s];
+                cells[c].status = -1;
+                c++;
+            }
+        }
+    }
+    if (thread_count > cell_count) {
+        thread_count = cell_count;
+    }
+
+    // Workers share the trace and the cell array; each cell is written by exactly one worker
+    SweepQueue queue = {&trace, &timing, cells, cell_count, 0};
+    pthread_t* threads = (pthread_t*)malloc(thread_count * sizeof(pthread_t));
+    if (threads == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        free(cells);
+        trace_free(&trace);
+        return 1;
+    }
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    long started = 0;
+    while (started < thread_count && pthread_create(&threads[started], NULL, sweep_worker, &queue) == 0) {
+        started++;
+    }
+    if (started == 0) {
+        sweep_worker(&queue);
+    }
+    for (long t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    free(threads);
+
+    int status = 0;
+    double busy_ms = 0;
+    for (c = 0; c < cell_count; c++) {
+        if (cells[c].status != 0) {
+            printf("Error: %s with %d frames and %d KB pages failed.\n",
+                   cells[c].policy->name, cells[c].frame_count, cells[c].page_kb);
+            status = 1;
+        }
+        busy_ms += cells[c].result.elapsed_us / 1000.0;
+    }
+    double wall_ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0;
+    printf("Ran %d cells over %zu references on %ld threads in %.2f ms (%.2f ms of replay summed over cells)\n",
+           cell_count, trace.count, started > 0 ? started : 1, wall_ms, busy_ms);
+    if (status == 0) {
+        status = write_sweep_results(&queue, output_path);
+        if (status == 0) {
+            printf("Results written to %s\n", output_path);
+        }
+    }
+
+    free(cells);
+    trace_free(&trace);
+    return status;
+}
+
+// Function to push a frame onto the lock-free free-frame stack. The head carries a 32-bit tag
+// above the index, bumped on every change, so a stale compare-and-swap cannot succeed (ABA).
+static void frame_pool_push(FramePool* pool, int frame, ConcurrentStats* stats) {
+    uint64_t head = __atomic_load_n(&pool->free_head, __ATOMIC_ACQUIRE);
+    for (;;) {
+        __atomic_store_n(&pool->next[frame], (int32_t)(uint32_t)head, __ATOMIC_RELAXED);
+        uint64_t desired = ((head >> 32) + 1) << 32 | (uint32_t)frame;
+        if (__atomic_compare_exchange_n(&pool->free_head, &head, desired, 1, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+            return;
+        }
+        stats->free_list_retries++;
+    }
+}
+
+// Function to pop a free frame from the lock-free stack; -1 when it is empty
+static int frame_pool_pop(FramePool* pool, ConcurrentStats* stats) {
+    uint64_t head = __atomic_load_n(&pool->free_head, __ATOMIC_ACQUIRE);
+    for (;;) {
+        int32_t frame = (int32_t)(uint32_t)head;
+        if (frame < 0) {
+            return -1;
+        }
+        int32_t next = __atomic_load_n(&pool->next[frame], __ATOMIC_RELAXED);
+        uint64_t desired = ((head >> 32) + 1) << 32 | (uint32_t)next;
+        if (__atomic_compare_exchange_n(&pool->free_head, &head, desired, 1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return frame;
+        }
+        stats->free_list_retries++;
+    }
+}
+
+// Function to take a swap slot from the stripe of the process that owns the page. Each stripe
+// has its own mutex, so processes on different stripes never wait for each other.
+static int swap_stripe_alloc(FramePool* pool, int stripe_index, ConcurrentStats* stats) {
+    SwapStripe* stripe = &pool->stripes[stripe_index];
+    if (pthread_mutex_trylock(&stripe->lock) != 0) {
+        stats->stripe_contended++;
+        pthread_mutex_lock(&stripe->lock);
+    }
+    stats->stripe_acquisitions++;
+    int slot = stripe->free_count > 0 ? stripe->free_slots[--stripe->free_count] : -1;
+    pthread_mutex_unlock(&stripe->lock);
+    return slot;
+}
+
+// Function to give a swap slot back to its stripe
+static void swap_stripe_free(FramePool* pool, int slot, ConcurrentStats* stats) {
+    SwapStripe* stripe = &pool->stripes[slot / pool->slots_per_stripe];
+    if (pthread_mutex_trylock(&stripe->lock) != 0) {
+        stats->stripe_contended++;
+        pthread_mutex_lock(&stripe->lock);
+    }
+    stats->stripe_acquisitions++;
+    stripe->free_slots[stripe->free_count++] = slot;
+    pthread_mutex_unlock(&stripe->lock);
+}
+
+// Function to evict one frame with a shared CLOCK hand. Threads advance the hand with an atomic
+// add, so each examines different frames; a frame whose lock is held (being filled or evicted by
+// another thread) is skipped. Returns the victim frame, locked and unmapped from its old owner,
+// or -1 when the hand meets a free frame or laps the pool twice without a victim: an exiting
+// process is releasing frames, so the caller should try the free stack again.
+static int frame_pool_evict(FramePool* pool, ConcurrentStats* stats) {
+    for (int steps = 0; steps < 2 * pool->frame_count; steps++) {
+        int frame = (int)(__atomic_fetch_add(&pool->hand, 1, __ATOMIC_RELAXED) % (uint64_t)pool->frame_count);
+        SharedFrame* candidate = &pool->frames[frame];
+        stats->clock_steps++;
+        if (__atomic_load_n(&candidate->referenced, __ATOMIC_RELAXED)) {
+            __atomic_store_n(&candidate->referenced, 0, __ATOMIC_RELAXED); // Second chance
+            continue;
+        }
+        uint8_t unlocked = 0;
+        if (!__atomic_compare_exchange_n(&candidate->lock, &unlocked, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            stats->frame_lock_misses++;
+            continue;
+        }
+        page_key old = __atomic_load_n(&candidate->key, __ATOMIC_RELAXED);
+        if (old == PAGE_KEY_NONE) {
+            __atomic_store_n(&candidate->lock, 0, __ATOMIC_RELEASE); // On the free list; pop it instead
+            return -1;
+        }
+
+        // Unmap the victim from its owner: to a swap slot if dirty, otherwise it is simply dropped
+        int owner = (int)(old >> 32) - 1;
+        int page = (int)(uint32_t)old;
+        int entry = PAGE_UNMAPPED;
+        if (__atomic_load_n(&candidate->dirty, __ATOMIC_RELAXED)) {
+            int slot = swap_stripe_alloc(pool, owner % pool->stripe_count, stats);
+            entry = slot >= 0 ? SWAP_SLOT_ENTRY(slot) : PAGE_UNMAPPED;
+            stats->writebacks++;
+        }
+        __atomic_store_n(&pool->page_tables[owner][page], entry, __ATOMIC_RELEASE);
+        __atomic_store_n(&candidate->key, PAGE_KEY_NONE, __ATOMIC_RELEASE);
+        stats->evictions++;
+        return frame;
+    }
+    return -1;
+}
+
+// Function to replay one reference of a process against the shared pool
+static void concurrent_reference(FramePool* pool, int process, uint32_t reference, ConcurrentStats* stats) {
+    int* page_table = pool->page_tables[process];
+    int page = (int)(reference & 0x7fffffff);
+    int write = (int)(reference >> 31);
+    page_key key = make_page_key((uint32_t)process + 1, (uint32_t)page);
+    int entry = __atomic_load_n(&page_table[page], __ATOMIC_ACQUIRE);
+    if (entry >= 0) {
+        SharedFrame* frame = &pool->frames[entry];
+        // Check the frame still holds the page; an evictor may have taken it since the entry was read
+        if (__atomic_load_n(&frame->key, __ATOMIC_ACQUIRE) == key) {
+            if (!__atomic_load_n(&frame->referenced, __ATOMIC_RELAXED)) {
+                __atomic_store_n(&frame->referenced, 1, __ATOMIC_RELAXED);
+            }
+            if (!write || __atomic_load_n(&frame->dirty, __ATOMIC_RELAXED)) {
+                stats->hits++;
+                return;
+            }
+            // First write to a clean page: set the dirty bit under the frame lock, or an evictor
+            // that has already read it as clean would drop the page and lose the write
+            uint8_t unlocked = 0;
+            while (!__atomic_compare_exchange_n(&frame->lock, &unlocked, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                unlocked = 0;
+                stats->frame_lock_misses++;
+            }
+            int still_mine = __atomic_load_n(&frame->key, __ATOMIC_RELAXED) == key;
+            if (still_mine) {
+                __atomic_store_n(&frame->dirty, 1, __ATOMIC_RELAXED);
+            }
+            __atomic_store_n(&frame->lock, 0, __ATOMIC_RELEASE);
+            if (still_mine) {
+                stats->hits++;
+                return;
+            }
+        }
+        stats->stale_entries++;
+        entry = __atomic_load_n(&page_table[page], __ATOMIC_ACQUIRE);
+    }
+
+    // Page fault: a free frame if the stack has one, otherwise evict, until one of them succeeds
+    stats->faults++;
+    if (PAGE_ON_DISK(entry)) {
+        stats->major_faults++;
+        swap_stripe_free(pool, ENTRY_SWAP_SLOT(entry), stats);
+    }
+    int frame_index;
+    for (;;) {
+        frame_index = frame_pool_pop(pool, stats);
+        if (frame_index >= 0) {
+            uint8_t unlocked = 0;
+            while (!__atomic_compare_exchange_n(&pool->frames[frame_index].lock, &unlocked, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                unlocked = 0; // An evictor is looking at the free frame; it lets go at once
+                stats->frame_lock_misses++;
+            }
+            break;
+        }
+        frame_index = frame_pool_evict(pool, stats);
+        if (frame_index >= 0) {
+            break;
+        }
+        sched_yield(); // A free frame is being pushed by an exiting process
+    }
+    SharedFrame* frame = &pool->frames[frame_index];
+    // A page back from swap gave up its slot, so it must be written again if evicted
+    __atomic_store_n(&frame->dirty, (uint8_t)(write || PAGE_ON_DISK(entry)), __ATOMIC_RELAXED);
+    __atomic_store_n(&frame->referenced, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&frame->key, key, __ATOMIC_RELEASE);
+    __atomic_store_n(&page_table[page], frame_index, __ATOMIC_RELEASE);
+    __atomic_store_n(&frame->lock, 0, __ATOMIC_RELEASE);
+}
+
+// Function to release a process's frames and swap slots when it exits
+static void concurrent_process_exit(FramePool* pool, int process, ConcurrentStats* stats) {
+    int* page_table = pool->page_tables[process];
+    for (int page = 0; page < pool->pages; page++) {
+        int entry = __atomic_load_n(&page_table[page], __ATOMIC_ACQUIRE);
+        if (entry >= 0) {
+            SharedFrame* frame = &pool->frames[entry];
+            uint8_t unlocked = 0;
+            while (!__atomic_compare_exchange_n(&frame->lock, &unlocked, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                unlocked = 0;
+                stats->frame_lock_misses++;
+            }
+            // An evictor may have taken the frame between reading the entry and locking it
+            int still_mine = __atomic_load_n(&frame->key, __ATOMIC_RELAXED) == make_page_key((uint32_t)process + 1, (uint32_t)page);
+            if (still_mine) {
+                __atomic_store_n(&frame->key, PAGE_KEY_NONE, __ATOMIC_RELEASE);
+                __atomic_store_n(&page_table[page], PAGE_UNMAPPED, __ATOMIC_RELEASE);
+            }
+            __atomic_store_n(&frame->lock, 0, __ATOMIC_RELEASE);
+            if (still_mine) {
+                frame_pool_push(pool, entry, stats);
+            } else {
+                entry = __atomic_load_n(&page_table[page], __ATOMIC_ACQUIRE);
+            }
+        }
+        if (PAGE_ON_DISK(entry)) {
+            swap_stripe_free(pool, ENTRY_SWAP_SLOT(entry), stats);
+        }
+    }
+}
+
+// Function run by each thread: the processes it was given take turns in quanta, as on one CPU's
+// run queue. All threads meet at a barrier after each round of quanta, so every process has run
+// the same share of its stream at each round boundary whatever the thread count.
+static void* concurrent_worker(void* arg) {
+    ConcurrentWorker* worker = (ConcurrentWorker*)arg;
+    FramePool* pool = worker->pool;
+    while (!__atomic_load_n(&pool->go, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+    for (size_t base = 0; base < pool->stream_length; base += CONCURRENT_QUANTUM) {
+        size_t end = base + CONCURRENT_QUANTUM < pool->stream_length ? base + CONCURRENT_QUANTUM : pool->stream_length;
+        for (int process = worker->first_process; process < pool->process_count; process += worker->process_stride) {
+            const uint32_t* stream = pool->streams[process];
+            for (size_t i = base; i < end; i++) {
+                concurrent_reference(pool, process, stream[i], &worker->stats);
+            }
+        }
+        pthread_barrier_wait(&pool->round_barrier);
+    }
+    for (int process = worker->first_process; process < pool->process_count; process += worker->process_stride) {
+        concurrent_process_exit(pool, process, &worker->stats);
+    }
+    return NULL;
+}
+
+// Function to set up a shared frame pool for one run: every frame on the free stack, one page table
+// per process and swap slots split into stripes
+static int frame_pool_init(FramePool* pool, int frame_count, uint32_t** streams, int process_count, int pages, size_t stream_length) {
+    memset(pool, 0, sizeof(*pool));
+    pool->frame_count = frame_count;
+    pool->streams = streams;
+    pool->stream_length = stream_length;
+    pool->pages = pages;
+    pool->stripe_count = process_count < SWAP_STRIPES ? process_count : SWAP_STRIPES;
+    pool->slots_per_stripe = (process_count + pool->stripe_count - 1) / pool->stripe_count * pages;
+    pool->frames = (SharedFrame*)calloc(frame_count, sizeof(SharedFrame));
+    pool->next = (int32_t*)malloc(frame_count * sizeof(int32_t));
+    pool->page_tables = (int**)calloc(process_count, sizeof(int*));
+    pool->stripes = (SwapStripe*)calloc(pool->stripe_count, sizeof(SwapStripe));
+    if (pool->frames == NULL || pool->next == NULL || pool->page_tables == NULL || pool->stripes == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        return 1;
+    }
+    pool->free_head = (uint32_t)-1;
+    for (int f = frame_count - 1; f >= 0; f--) {
+        pool->frames[f].key = PAGE_KEY_NONE;
+        pool->next[f] = (int32_t)(uint32_t)pool->free_head;
+        pool->free_head = (uint32_t)f;
+    }
+    pool->process_count = process_count;
+    for (int p = 0; p < process_count; p++) {
+        pool->page_tables[p] = (int*)malloc(pages * sizeof(int));
+        if (pool->page_tables[p] == NULL) {
+            printf("Error: Memory allocation failed.\n");
+            return 1;
+        }
+        for (int page = 0; page < pages; page++) {
+            pool->page_tables[p][page] = PAGE_UNMAPPED;
+        }
+    }
+    for (int s = 0; s < pool->stripe_count; s++) {
+        SwapStripe* stripe = &pool->stripes[s];
+        stripe->free_slots = (int*)malloc(pool->slots_per_stripe * sizeof(int));
+        if (stripe->free_slots == NULL) {
+            printf("Error: Memory allocation failed.\n");
+            return 1;
+        }
+        pthread_mutex_init(&stripe->lock, NULL);
+        for (int slot = 0; slot < pool->slots_per_stripe; slot++) {
+            stripe->free_slots[slot] = s * pool->slots_per_stripe + (pool->slots_per_stripe - 1 - slot);
+        }
+        stripe->free_count = pool->slots_per_stripe;
+    }
+    return 0;
+}
+
+static void frame_pool_free(FramePool* pool) {
+    for (int p = 0; pool->page_tables != NULL && p < pool->process_count; p++) {
+        free(pool->page_tables[p]);
+    }
+    for (int s = 0; pool->stripes != NULL && s < pool->stripe_count; s++) {
+        if (pool->stripes[s].free_slots != NULL) {
+            pthread_mutex_destroy(&pool->stripes[s].lock);
+        }
+        free(pool->stripes[s].free_slots);
+    }
+    free(pool->frames);
+    free(pool->next);
+    free(pool->page_tables);
+    free(pool->stripes);
+}
+
+// Function to run the same set of processes on 1, 2, 4, ... threads sharing one frame pool. The
+// processes, their reference streams and the quantum rounds stay fixed, so only the parallelism
+// changes; at the largest thread count every process has a thread of its own. The order of
+// references within a round still depends on scheduling, so a run is only given a speedup over
+// the first when their fault counts agree, and never when it has more threads than online CPUs.
+int run_concurrent_simulation(int argc, char* argv[]) {
+    int thread_counts[MAX_SWEEP_VALUES] = {1, 2, 4, 8, 16, 32, 64};
+    int thread_value_count = 7;
+    int frame_count = 16384;
+    WorkloadParams params;
+    workload_params_defaults(&params);
+    params.references = 4000000; // Split evenly between the processes
+    params.pages = 1024;
+    params.processes = 64;
+    int valid = 1;
+    for (int i = 1; i < argc; i++) {
+        int consumed = parse_workload_option(argc, argv, i, &params);
+        if (consumed > 0) {
+            i += consumed - 1;
+        } else if (strcmp(argv[i], "--concurrent") == 0) {
+            continue;
+        } else if (strcmp(argv[i], "--threads-list") == 0 && i + 1 < argc) {
+            thread_value_count = parse_int_list(argv[++i], thread_counts, MAX_SWEEP_VALUES);
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frame_count = atoi(argv[++i]);
+        } else {
+            valid = 0;
+            break;
+        }
+    }
+    if (!valid) {
+        printf("Usage: %s --concurrent [--threads-list 1,2,4,...] [--frames N] [--refs N] [--pages N] [--processes N]\n", argv[0]);
+        printf("           [--write-ratio F] [--theta F] [--seed N]\n");
+        return 1;
+    }
+    if (thread_value_count <= 0 || frame_count <= 0 || params.processes <= 0 || params.pages <= 0 ||
+        params.references < (size_t)params.processes || params.zipf_theta <= 0 || params.zipf_theta == 1) {
+        printf("Invalid parameters. Thread counts, frames, pages and processes must be greater than 0, "
+               "with at least one reference per process.\n");
+        return 1;
+    }
+    for (int t = 0; t < thread_value_count; t++) {
+        if (thread_counts[t] > params.processes) {
+            printf("Invalid thread count %d. There are only %d processes to run.\n", thread_counts[t], params.processes);
+            return 1;
+        }
+    }
+
+    // Each process gets its own seeded Zipfian stream, generated once before any clock starts
+    size_t stream_length = params.references / params.processes;
+    uint32_t** streams = (uint32_t**)calloc(params.processes, sizeof(uint32_t*));
+    int status = streams == NULL;
+    for (int p = 0; p < params.processes && status == 0; p++) {
+        uint64_t rng = params.seed * 1000003ULL + (uint64_t)p;
+        ZipfSampler zipf;
+        streams[p] = (uint32_t*)malloc(stream_length * sizeof(uint32_t));
+        if (streams[p] == NULL || zipf_init(&zipf, params.pages, params.zipf_theta, &rng) != 0) {
+            status = 1;
+            break;
+        }
+        for (size_t i = 0; i < stream_length; i++) {
+            uint32_t write = workload_uniform(&rng) < params.write_ratio;
+            streams[p][i] = (uint32_t)(zipf_next(&zipf, &rng) - 1) | write << 31;
+        }
+        zipf_free(&zipf);
+    }
+    if (status != 0) {
+        printf("Error: Memory allocation failed.\n");
+    }
+
+    long online_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("%d processes of %zu references over %d pages each, on a shared pool of %d frames, seed %llu, %ld online CPUs\n",
+           params.processes, stream_length, params.pages, frame_count, (unsigned long long)params.seed, online_cpus);
+    printf("+---------+------------+--------------+---------+------------+------------+------------+------------+------------+------------+\n");
+    printf("| Threads | Wall (ms)  | Refs/s       | Speedup | Fault Rate | Evictions  | Free-List  | Frame Lock | Clock Steps| Stripe     |\n");
+    printf("|         |            |              |         |            |            | CAS Retry  | Misses     | per Evict  | Contended  |\n");
+    printf("+---------+------------+--------------+---------+------------+------------+------------+------------+------------+------------+\n");
+    double base_rate = 0;
+    long long base_faults = 0;
+    int oversubscribed = 0;
+    int diverged = 0;
+    for (int t = 0; t < thread_value_count && status == 0; t++) {
+        int threads = thread_counts[t];
+        ConcurrentWorker* workers = (ConcurrentWorker*)calloc(threads, sizeof(ConcurrentWorker));
+        pthread_t* handles = (pthread_t*)malloc(threads * sizeof(pthread_t));
+        FramePool pool;
+        memset(&pool, 0, sizeof(pool));
+        if (workers == NULL || handles == NULL ||
+            frame_pool_init(&pool, frame_count, streams, params.processes, params.pages, stream_length) != 0) {
+            printf("Error: Memory allocation failed.\n");
+            status = 1;
+        }
+
+        int started = 0;
+        struct timespec start, end;
+        if (status == 0) {
+            for (int w = 0; w < threads; w++) {
+                workers[w].pool = &pool;
+                workers[w].first_process = w;
+                workers[w].process_stride = threads;
+            }
+            while (started < threads && pthread_create(&handles[started], NULL, concurrent_worker, &workers[started]) == 0) {
+                started++;
+            }
+            if (started < threads) {
+                printf("Error: Could only start %d of %d threads.\n", started, threads);
+                status = 1;
+            }
+            // Sized to the threads actually started, so a failed start still lets them finish
+            pthread_barrier_init(&pool.round_barrier, NULL, started > 0 ? started : 1);
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            __atomic_store_n(&pool.go, 1, __ATOMIC_RELEASE); // Threads wait for this so all start together
+            for (int w = 0; w < started; w++) {
+                pthread_join(handles[w], NULL);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            pthread_barrier_destroy(&pool.round_barrier);
+        }
+
+        if (status == 0) {
+            ConcurrentStats total;
+            memset(&total, 0, sizeof(total));
+            for (int w = 0; w < threads; w++) {
+                const ConcurrentStats* s = &workers[w].stats;
+                total.hits += s->hits;
+                total.faults += s->faults;
+                total.major_faults += s->major_faults;
+                total.evictions += s->evictions;
+                total.writebacks += s->writebacks;
+                total.clock_steps += s->clock_steps;
+                total.free_list_retries += s->free_list_retries;
+                total.frame_lock_misses += s->frame_lock_misses;
+                total.stale_entries += s->stale_entries;
+                total.stripe_contended += s->stripe_contended;
+                total.stripe_acquisitions += s->stripe_acquisitions;
+            }
+            double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+            long long references = total.hits + total.faults;
+            double rate = seconds > 0 ? references / seconds : 0;
+            if (t == 0) {
+                base_rate = rate;
+                base_faults = total.faults;
+            }
+            // Threads beyond the CPUs time-share, and a different fault count is different work
+            char thread_label[16];
+            char speedup[16];
+            int over = online_cpus > 0 && threads > online_cpus;
+            int same_work = llabs(total.faults - base_faults) <= CONCURRENT_FAULT_TOLERANCE * base_faults;
+            snprintf(thread_label, sizeof(thread_label), over ? "%d*" : "%d", threads);
+            if (over || !same_work || base_rate <= 0) {
+                snprintf(speedup, sizeof(speedup), "n/a");
+            } else {
+                snprintf(speedup, sizeof(speedup), "%.2fx", rate / base_rate);
+            }
+            oversubscribed |= over;
+            diverged |= !same_work;
+            char stripes[32];
+            snprintf(stripes, sizeof(stripes), "%.2f%%",
+                     total.stripe_acquisitions > 0 ? 100.0 * total.stripe_contended / total.stripe_acquisitions : 0.0);
+            printf("| %7s | %10.2f | %12.0f | %7s | %10.4f | %10lld | %10lld | %10lld | %10.2f | %10s |\n",
+                   thread_label, seconds * 1000, rate, speedup,
+                   references > 0 ? (double)total.faults / references : 0, total.evictions, total.free_list_retries,
+                   total.frame_lock_misses, total.evictions > 0 ? (double)total.clock_steps / total.evictions : 0, stripes);
+        }
+        free(workers);
+        free(handles);
+        frame_pool_free(&pool);
+    }
+    printf("+---------+------------+--------------+---------+------------+------------+------------+------------+------------+------------+\n");
+    if (oversubscribed) {
+        printf("* More threads than online CPUs: the threads time-share, so no speedup is reported.\n");
+    }
+    if (diverged) {
+        printf("Speedup is n/a where the fault count differs from the first run's by more than %.0f%%.\n",
+               CONCURRENT_FAULT_TOLERANCE * 100);
+    }
+    for (int p = 0; streams != NULL && p < params.processes; p++) {
+        free(streams[p]);
+    }
+    free(streams);
+    return status;
+}
+
+// Function to parse the workload options shared by --generate and --bench-suite; returns the
+// arguments consumed, 0 if argv[i] is not a workload option
+int parse_workload_option(int argc, char* argv[], int i, WorkloadParams* params) {
+    if (i + 1 >= argc) {
+        return 0;
+    }
+    if (strcmp(argv[i], "--refs") == 0) {
+        params->references = (size_t)strtoull(argv[i + 1], NULL, 10);
+    } else if (strcmp(argv[i], "--pages") == 0) {
+        params->pages = atoi(argv[i + 1]);
+    } else if (strcmp(argv[i], "--processes") == 0) {
+        params->processes = atoi(argv[i + 1]);
+    } else if (strcmp(argv[i], "--write-ratio") == 0) {
+        params->write_ratio = atof(argv[i + 1]);
+    } else if (strcmp(argv[i], "--theta") == 0) {
+        params->zipf_theta = atof(argv[i + 1]);
+    } else if (strcmp(argv[i], "--seed") == 0) {
+        params->seed = strtoull(argv[i + 1], NULL, 10);
+    } else {
+        return 0;
+    }
+    return 2;
+}
+
+// Function to fill in the default workload: 1M references over 4096 pages per process
+void workload_params_defaults(WorkloadParams* params) {
+    params->references = 1000000;
+    params->pages = 4096;
+    params->processes = 4;
+    params->write_ratio = 0.3;
+    params->zipf_theta = 0.99;
+    params->seed = 1;
+}
+
+// Function to write one generated workload as a trace file for the other modes
+int run_workload_generate(int argc, char* argv[]) {
+    const char* name = NULL;
+    const char* output_path = NULL;
+    WorkloadParams params;
+    workload_params_defaults(&params);
+    for (int i = 1; i < argc; i++) {
+        int consumed = parse_workload_option(argc, argv, i, &params);
+        if (consumed > 0) {
+            i += consumed - 1;
+        } else if (strcmp(argv[i], "--generate") == 0 && i + 1 < argc) {
+            name = argv[++i];
+        } else if (strcmp(argv[i], "--trace-out") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else {
+            name = NULL;
+            break;
+        }
+    }
+    const WorkloadGenerator* generator = name != NULL ? find_workload(name) : NULL;
+    if (generator == NULL || output_path == NULL) {
+        printf("Usage: %s --generate NAME --trace-out <file> [--refs N] [--pages N] [--processes N]\n", argv[0]);
+        printf("           [--write-ratio F] [--theta F] [--seed N]\n");
+        printf("Workloads:");
+        for (int g = 0; g < workload_generator_count; g++) {
+            printf(" %s", workload_generators[g].name);
+        }
+        printf("\n");
+        return 1;
+    }
+    Trace trace;
+    if (generate_workload(generator, &params, &trace) != 0) {
+        return 1;
+    }
+    int status = trace_write(&trace, output_path);
+    if (status == 0) {
+        printf("Wrote %zu references of %s (%s) to %s\n", trace.count, generator->name, generator->description, output_path);
+    }
+    trace_free(&trace);
+    return status;
+}
+
+// Function to write the suite's rows as CSV or, for a .json path, a JSON array
+static int write_bench_rows(const BenchRow* rows, int row_count, const WorkloadParams* params, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        printf("Error: Could not open %s for writing.\n", path);
+        return 1;
+    }
+    size_t length = strlen(path);
+    int json = length >= 5 && strcmp(path + length - 5, ".json") == 0;
+    if (json) {
+        fprintf(file, "[\n");
+    } else {
+        fprintf(file, "kind,workload,path,seed,operations,throughput_per_s,fault_rate,virtual_ms,p50_us,p99_us,p999_us\n");
+    }
+    for (int r = 0; r < row_count; r++) {
+        const BenchRow* row = &rows[r];
+        if (json) {
+            fprintf(file, "  {\"kind\": \"%s\", \"workload\": \"%s\", \"path\": \"%s\", \"seed\": %llu, \"operations\": %lld, "
+                          "\"throughput_per_s\": %.1f, \"fault_rate\": %.6f, \"virtual_ms\": %.3f, "
+                          "\"p50_us\": %.3f, \"p99_us\": %.3f, \"p999_us\": %.3f}%s\n",
+                    row->kind, row->workload, row->path, (unsigned long long)params->seed, row->operations,
+                    row->throughput, row->fault_rate, row->virtual_ms, row->p50_us, row->p99_us, row->p999_us,
+                    r + 1 < row_count ? "," : "");
+        } else {
+            fprintf(file, "%s,%s,%s,%llu,%lld,%.1f,%.6f,%.3f,%.3f,%.3f,%.3f\n",
+                    row->kind, row->workload, row->path, (unsigned long long)params->seed, row->operations,
+                    row->throughput, row->fault_rate, row->virtual_ms, row->p50_us, row->p99_us, row->p999_us);
+        }
+    }
+    if (json) {
+        fprintf(file, "]\n");
+    }
+    if (fclose(file) != 0) {
+        printf("Error: Could not write %s.\n", path);
+        return 1;
+    }
+    return 0;
+}
+
+// Function to run every workload generator against every replacement policy, and the allocation
+// churn against every contiguous allocator, writing one machine-readable row per pair
+int run_benchmark_suite(int argc, char* argv[]) {
+    const char* output_path = NULL;
+    int frame_count = 1024;
+    WorkloadParams params;
+    workload_params_defaults(&params);
+    TimingModel timing = timing_model;
+    for (int i = 1; i < argc; i++) {
+        int consumed = parse_workload_option(argc, argv, i, &params);
+        if (consumed == 0) {
+            consumed = parse_timing_option(argc, argv, i, &timing);
+        }
+        if (consumed < 0) {
+            return 1;
+        } else if (consumed > 0) {
+            i += consumed - 1;
+        } else if (strcmp(argv[i], "--bench-suite") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            frame_count = atoi(argv[++i]);
+        } else {
+            output_path = NULL;
+            break;
+        }
+    }
+    if (output_path == NULL) {
+        printf("Usage: %s --bench-suite <out.csv|out.json> [--frames N] [--refs N] [--pages N] [--processes N]\n", argv[0]);
+        printf("           [--write-ratio F] [--theta F] [--seed N] [--device nvme|ssd|hdd] [--queue-depth N]\n");
+        return 1;
+    }
+    if (frame_count <= 0 || timing.page_kb <= 0 || timing.queue_depth <= 0) {
+        printf("Invalid frame count or timing model. Please enter values greater than 0.\n");
+        return 1;
+    }
+
+    int row_capacity = workload_generator_count * replacement_policy_count + contiguous_allocator_count;
+    BenchRow* rows = (BenchRow*)calloc(row_capacity, sizeof(BenchRow));
+    if (rows == NULL) {
+        printf("Error: Memory allocation failed.\n");
+        return 1;
+    }
+    int row_count = 0;
+    int status = 0;
+    printf("Suite: %zu references over %d pages, %d frames, seed %llu, %s\n", params.references, params.pages,
+           frame_count, (unsigned long long)params.seed, timing.device->name);
+    printf("+------------+------------+--------------+------------+--------------+------------+------------+------------+\n");
+    printf("| Workload   | Path       | Ops/s        | Fault Rate | Virtual (ms) | p50 (us)   | p99 (us)   | p99.9 (us) |\n");
+    printf("+------------+------------+--------------+------------+--------------+------------+------------+------------+\n");
+    for (int g = 0; g < workload_generator_count && status == 0; g++) {
+        Trace trace;
+        if (generate_workload(&workload_generators[g], &params, &trace) != 0) {
+            status = 1;
+            break;
+        }
+        for (int p = 0; p < replacement_policy_count && status == 0; p++) {
+            ReplayResult result;
+            if (replay_trace(&trace, frame_count, &replacement_policies[p], &timing, 0, &result) != 0) {
+                status = 1;
+                break;
+            }
+            BenchRow* row = &rows[row_count++];
+            row->kind = "replacement";
+            row->workload = workload_generators[g].name;
+            row->path = replacement_policies[p].name;
+            row->operations = result.references;
+            row->throughput = result.elapsed_us > 0 ? result.references / (result.elapsed_us / 1e6) : 0;
+            row->fault_rate = (double)result.page_faults / result.references;
+            row->virtual_ms = result.virtual_time_us / 1000.0;
+            row->p50_us = result.p50_latency_us;
+            row->p99_us = result.p99_latency_us;
+            row->p999_us = result.p999_latency_us;
+        }
+        trace_free(&trace);
+    }
+
+    // Allocation paths run the seeded churn workload; their latency is measured, not simulated
+    for (int a = 0; a < contiguous_allocator_count && status == 0; a++) {
+        ChurnResult result;
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (run_allocation_churn(&contiguous_allocators[a], 1 << 18, (long long)params.references, 0.85, params.seed, &result) != 0) {
+            status = 1;
+            break;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        BenchRow* row = &rows[row_count++];
+        row->kind = "allocation";
+        row->workload = "churn";
+        row->path = contiguous_allocators[a].name;
+        row->operations = (long long)params.references;
+        row->throughput = seconds > 0 ? params.references / seconds : 0;
+        row->fault_rate = result.allocations > 0 ? (double)result.failures / result.allocations : 0;
+        row->virtual_ms = 0;
+        row->p50_us = result.p50_alloc_ns / 1000.0;
+        row->p99_us = result.p99_alloc_ns / 1000.0;
+        row->p999_us = result.p999_alloc_ns / 1000.0;
+    }
+
+    for (int r = 0; r < row_count; r++) {
+        const BenchRow* row = &rows[r];
+        printf("| %-10s | %-10s | %12.0f | %10.4f | %12.2f | %10.3f | %10.3f | %10.3f |\n", row->workload, row->path,
+               row->throughput, row->fault_rate, row->virtual_ms, row->p50_us, row->p99_us, row->p999_us);
+    }
+    printf("+------------+------------+--------------+------------+--------------+------------+------------+------------+\n");
+    if (status == 0) {
+        status = write_bench_rows(rows, row_count, &params, output_path);
+        if (status == 0) {
+            printf("Results written to %s\n", output_path);
+        }
+    }
+    free(rows);
+    return status;
+}
+
+// Function to dispatch the non-interactive modes selected from the command line
+int run_command_line(int argc, char* argv[]) {
+    if (strcmp(argv[1], "--bench-lru") == 0) {
+        return run_lru_benchmark();
+    }
+    if (strcmp(argv[1], "--bench-lookup") == 0) {
+        return run_lookup_benchmark();
+    }
+    if (strcmp(argv[1], "--bench-alloc") == 0) {
+        return run_allocation_benchmark(argc, argv);
+    }
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--mrc") == 0) {
+            return run_miss_ratio_curve(argc, argv);
+        }
+        if (strcmp(argv[i], "--sweep") == 0) {
+            return run_sweep(argc, argv);
+        }
+        if (strcmp(argv[i], "--bench-suite") == 0) {
+            return run_benchmark_suite(argc, argv);
+        }
+        if (strcmp(argv[i], "--generate") == 0) {
+            return run_workload_generate(argc, argv);
+        }
+        if (strcmp(argv[i], "--concurrent") == 0) {
+            return run_concurrent_simulation(argc, argv);
+        }
+    }
+    return run_trace_replay(argc, argv);
 }